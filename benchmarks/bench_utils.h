@@ -0,0 +1,190 @@
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <algorithm>
+#include <chrono>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Keeps a benchmarked value alive so the compiler cannot drop the work producing it
+template <typename T>
+void doNotOptimize(const T& value) {
+#if defined(_MSC_VER)
+    static const void* volatile sink;
+    sink = &value;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+// One measured benchmark
+struct BenchmarkResult {
+    std::string name;
+    long long iterations = 0;
+    double ns_per_op = 0.0;
+    double bytes_per_op = 0.0; // Input bytes one operation touches, 0 when not meaningful
+};
+
+// Options shared by all benchmark executables
+struct BenchmarkOptions {
+    double iteration_scale = 1.0; // --quick runs a tenth of the iterations
+    std::string format = "text"; // text, csv or json
+    std::string output; // Results file for csv/json, stdout when empty
+    std::string baseline; // CSV of an earlier run to compare against
+    double tolerance = 0.25; // Allowed slowdown against the baseline
+};
+
+inline BenchmarkOptions& benchmarkOptions() {
+    static BenchmarkOptions options;
+    return options;
+}
+
+inline std::vector<BenchmarkResult>& benchmarkResults() {
+    static std::vector<BenchmarkResult> results;
+    return results;
+}
+
+// Function to read the common options, unknown ones are left to the executable
+inline void parseBenchmarkArgs(int argc, char** argv) {
+    BenchmarkOptions& options = benchmarkOptions();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--quick") {
+            options.iteration_scale = 0.1;
+        } else if (arg == "--format" && i + 1 < argc) {
+            options.format = argv[++i];
+        } else if (arg == "--output" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            options.baseline = argv[++i];
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            options.tolerance = std::stod(argv[++i]);
+        }
+    }
+}
+
+// Function to time a callable over a number of iterations, print and record ns per op
+template <typename Func>
+double runBenchmark(const std::string& name, long long iterations, double bytes_per_op, Func&& func) {
+    iterations = std::max(1LL, static_cast<long long>(iterations * benchmarkOptions().iteration_scale));
+
+    // Warm up caches and branch predictors
+    for (long long i = 0; i < iterations / 10 + 1; ++i) {
+        func();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < iterations; ++i) {
+        func();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns_per_op = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    benchmarkResults().push_back({name, iterations, ns_per_op, bytes_per_op});
+
+    if (benchmarkOptions().format == "text" || !benchmarkOptions().output.empty()) {
+        std::cout << std::left << std::setw(48) << name << std::right << std::setw(14) << std::fixed
+                  << std::setprecision(1) << ns_per_op << " ns/op";
+        if (bytes_per_op > 0.0) {
+            std::cout << std::setw(12) << std::setprecision(2) << bytes_per_op / ns_per_op << " GB/s";
+        }
+        std::cout << std::endl;
+    }
+    return ns_per_op;
+}
+
+template <typename Func>
+double runBenchmark(const std::string& name, long long iterations, Func&& func) {
+    return runBenchmark(name, iterations, 0.0, std::forward<Func>(func));
+}
+
+// Function to write the recorded results as CSV or JSON, to the output file or stdout
+inline bool writeBenchmarkResults() {
+    const BenchmarkOptions& options = benchmarkOptions();
+    if (options.format == "text") {
+        return true;
+    }
+
+    std::ofstream file;
+    if (!options.output.empty()) {
+        file.open(options.output);
+        if (!file) {
+            std::cerr << "Could not write benchmark results: " << options.output << std::endl;
+            return false;
+        }
+    }
+    std::ostream& out = options.output.empty() ? std::cout : file;
+    out << std::setprecision(6);
+
+    if (options.format == "csv") {
+        out << "name,iterations,ns_per_op,bytes_per_op\n";
+        for (const BenchmarkResult& result : benchmarkResults()) {
+            out << result.name << "," << result.iterations << "," << result.ns_per_op << "," << result.bytes_per_op << "\n";
+        }
+    } else {
+        out << "[\n";
+        for (size_t i = 0; i < benchmarkResults().size(); ++i) {
+            const BenchmarkResult& result = benchmarkResults()[i];
+            out << "  {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+                << ", \"ns_per_op\": " << result.ns_per_op << ", \"bytes_per_op\": " << result.bytes_per_op << "}"
+                << (i + 1 < benchmarkResults().size() ? "," : "") << "\n";
+        }
+        out << "]\n";
+    }
+    return true;
+}
+
+// Function to compare the recorded results with a baseline CSV, returns false if any benchmark
+// slowed down by more than the tolerance
+inline bool checkBenchmarkBaseline() {
+    const BenchmarkOptions& options = benchmarkOptions();
+    if (options.baseline.empty()) {
+        return true;
+    }
+    std::ifstream file(options.baseline);
+    if (!file) {
+        std::cerr << "Could not open benchmark baseline: " << options.baseline << std::endl;
+        return false;
+    }
+
+    std::map<std::string, double> baseline;
+    std::string line;
+    std::getline(file, line); // Header
+    while (std::getline(file, line)) {
+        std::stringstream fields(line);
+        std::string name, iterations, ns_per_op;
+        if (std::getline(fields, name, ',') && std::getline(fields, iterations, ',') && std::getline(fields, ns_per_op, ',')) {
+            baseline[name] = std::stod(ns_per_op);
+        }
+    }
+
+    bool passed = true;
+    for (const BenchmarkResult& result : benchmarkResults()) {
+        auto it = baseline.find(result.name);
+        if (it != baseline.end() && result.ns_per_op > it->second * (1.0 + options.tolerance)) {
+            std::cerr << "Regression: " << result.name << " " << result.ns_per_op << " ns/op, baseline " << it->second
+                      << " ns/op" << std::endl;
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+// Function to end a benchmark executable: write the results, check the baseline and return the exit code
+inline int finishBenchmarks() {
+    bool written = writeBenchmarkResults();
+    bool passed = checkBenchmarkBaseline();
+    return written && passed ? 0 : 1;
+}
+
+#endif // BENCH_UTILS_H
@@ -0,0 +1,107 @@
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <tbb/parallel_for.h>
+#include "bench_utils.h"
+#include "multi_camera_setup/camera_state.h"
+#include "multi_camera_setup/optical_flow.h"
+#include "multi_camera_setup/correlation_tracker.h"
+
+// Same fields as CameraTrackState without the cache line alignment, neighbours share lines
+struct PackedTrackState {
+    cv::Point2f current_tracker_position;
+    cv::Point2f previous_tracker_position;
+    cv::Point2f tracker_speed;
+    float tracker_radius = 0.0f;
+    cv::Point2d undistorted_position;
+    bool is_detection_active = false;
+    bool is_detection_valid = false;
+    bool is_tracking = false;
+    TrackerMode tracker_mode = TrackerMode::FullDetection;
+    int frames_since_detection = 0;
+    double tracking_ms = 0.0;
+    SimpleKalmanFilter kalman_fitler;
+};
+
+// Layout of Camera before the hot/cold split: the tracking state embedded between cold members
+struct LegacyCamera {
+    std::string name = "camera";
+    std::vector<double> tvec = std::vector<double>(3);
+    std::vector<double> rvec = std::vector<double>(3);
+    std::vector<std::vector<double>> K = std::vector<std::vector<double>>(3, std::vector<double>(3));
+    std::vector<double> dist;
+    cv::Mat current_frame;
+    cv::Mat background;
+    cv::VideoCapture capture;
+    OpticalFlowTracker flow_tracker;
+    CorrelationTracker correlation_tracker;
+    PackedTrackState hot;
+};
+
+PackedTrackState& hotState(LegacyCamera& camera) { return camera.hot; }
+PackedTrackState& hotState(PackedTrackState& state) { return state; }
+CameraTrackState& hotState(CameraTrackState& state) { return state; }
+
+// Function to run the per camera part of a frame, the writes trackBallInFrame does to the hot state
+template <typename State>
+void updateCamera(State& state, int frame_index) {
+    cv::Point2f measurement(100.0f + frame_index, 200.0f + 0.5f * frame_index);
+    state.current_tracker_position = state.kalman_fitler.predict();
+    state.current_tracker_position = state.kalman_fitler.correct(measurement, 1e-2f);
+    state.tracker_speed = state.current_tracker_position - state.previous_tracker_position;
+    state.previous_tracker_position = state.current_tracker_position;
+    state.undistorted_position = state.current_tracker_position;
+    state.is_detection_valid = (frame_index & 3) != 0;
+    state.frames_since_detection = state.is_detection_valid ? 0 : state.frames_since_detection + 1;
+    state.tracking_ms += 1e-3;
+}
+
+// Function to time one layout: the parallel per camera updates, then the serial gather of observations
+template <typename Entry>
+void benchmarkLayout(const std::string& label, std::vector<Entry>& entries) {
+    const size_t cameras_num = entries.size();
+    std::vector<cv::Point2d> image_points(cameras_num);
+    std::vector<uint8_t> valid(cameras_num);
+    int frame_index = 0;
+
+    runBenchmark(label + " parallel update", 2000, [&]() {
+        // Grain size 1 spreads neighbouring cameras over different workers, the false sharing case
+        tbb::parallel_for(size_t(0), cameras_num, size_t(1), [&](size_t i) {
+            for (int repeat = 0; repeat < 8; ++repeat) {
+                updateCamera(hotState(entries[i]), frame_index);
+            }
+        });
+        frame_index++;
+    });
+
+    runBenchmark(label + " gather", 200000, [&]() {
+        for (size_t i = 0; i < cameras_num; ++i) {
+            auto& state = hotState(entries[i]);
+            image_points[i] = state.undistorted_position;
+            valid[i] = state.is_detection_valid ? 1 : 0;
+        }
+        doNotOptimize(image_points.data());
+    });
+}
+
+int main(int argc, char** argv) {
+    parseBenchmarkArgs(argc, argv);
+
+    std::cout << "sizeof LegacyCamera " << sizeof(LegacyCamera) << ", PackedTrackState " << sizeof(PackedTrackState)
+              << ", CameraTrackState " << sizeof(CameraTrackState) << std::endl;
+
+    for (size_t cameras_num : {64, 128, 256}) {
+        std::string prefix = std::to_string(cameras_num) + " cameras, ";
+
+        std::vector<LegacyCamera> legacy(cameras_num);
+        benchmarkLayout(prefix + "AoS Camera", legacy);
+
+        std::vector<PackedTrackState> packed(cameras_num);
+        benchmarkLayout(prefix + "SoA packed", packed);
+
+        std::vector<CameraTrackState> aligned(cameras_num);
+        benchmarkLayout(prefix + "SoA aligned", aligned);
+    }
+    return finishBenchmarks();
+}
@@ -0,0 +1,80 @@
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include "bench_utils.h"
+#include "multi_camera_setup/tracking.h"
+
+// Function to render a textured 1280x1024 frame with the ball at the given position
+cv::Mat renderFrame(const cv::Mat& texture, const cv::Point2f& ball) {
+    cv::Mat frame = texture.clone();
+    cv::circle(frame, cv::Point(cvRound(ball.x), cvRound(ball.y)), 12, cv::Scalar(180, 60, 230), -1);
+    return frame;
+}
+
+int main(int argc, char** argv) {
+    parseBenchmarkArgs(argc, argv);
+
+    cv::Mat texture(1024, 1280, CV_8UC3);
+    cv::randu(texture, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::GaussianBlur(texture, texture, cv::Size(9, 9), 3.0);
+
+    const int frames_num = 64;
+    std::vector<cv::Mat> frames;
+    std::vector<cv::Point2f> positions;
+    for (int i = 0; i < frames_num; ++i) {
+        cv::Point2f ball(400.0f + 6.0f * i, 300.0f + 4.0f * i);
+        positions.push_back(ball);
+        frames.push_back(renderFrame(texture, ball));
+    }
+
+    std::cout << "Per camera per frame tracking cost" << std::endl;
+
+    CameraTrackState state;
+    Camera camera("bench", {0, 0, 0}, {0, 0, 0}, {{1000, 0, 640}, {0, 1000, 512}, {0, 0, 1}}, {}, 0, state);
+    camera.setBackground(texture);
+
+    int frame = 1;
+    runBenchmark("trackerByDetection (full frame)", 50, [&]() {
+        camera.current_frame = frames[frame];
+        trackerByDetection(camera);
+        doNotOptimize(camera.state->current_tracker_position);
+        frame = frame % (frames_num - 1) + 1;
+    });
+
+    frame = 1;
+    runBenchmark("trackerByDetection (128x128 window)", 2000, [&]() {
+        camera.current_frame = frames[frame];
+        cv::Point center(cvRound(positions[frame].x), cvRound(positions[frame].y));
+        trackerByDetection(camera, cv::Rect(center.x - 64, center.y - 64, 128, 128));
+        doNotOptimize(camera.state->current_tracker_position);
+        frame = frame % (frames_num - 1) + 1;
+    });
+
+    OpticalFlowTracker flow;
+    frame = 1;
+    runBenchmark("OpticalFlowTracker (ROI, reused pyramid, FB)", 2000, [&]() {
+        if (frame == 1) {
+            flow.prepare(frames[0], positions[0]);
+        }
+        cv::Point2f tracked;
+        bool valid = flow.track(frames[frame], positions[frame - 1], positions[frame - 1], tracked);
+        doNotOptimize(valid);
+        frame = frame % (frames_num - 1) + 1;
+    });
+
+    CorrelationTracker correlation;
+    frame = 1;
+    int lost = 0;
+    runBenchmark("CorrelationTracker (MOSSE 64x64)", 2000, [&]() {
+        if (frame == 1) {
+            correlation.init(frames[0], positions[0]);
+        }
+        cv::Point2f tracked;
+        bool valid = correlation.update(frames[frame], positions[frame - 1], tracked);
+        lost += valid ? 0 : 1;
+        doNotOptimize(tracked);
+        frame = frame % (frames_num - 1) + 1;
+    });
+    std::cout << "Correlation filter frames below the PSR threshold: " << lost << std::endl;
+    return finishBenchmarks();
+}
@@ -0,0 +1,72 @@
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include "bench_utils.h"
+#include "multi_camera_setup/kalman.h"
+
+// The cv::KalmanFilter based implementation SimpleKalmanFilter replaced, kept as the baseline
+class OpenCvKalmanFilter {
+public:
+    OpenCvKalmanFilter() {
+        KF.init(4, 2, 0, CV_32F);
+        KF.transitionMatrix = (cv::Mat_<float>(4, 4) << 1, 0, 1, 0,
+                                                        0, 1, 0, 1,
+                                                        0, 0, 1, 0,
+                                                        0, 0, 0, 1);
+        KF.measurementMatrix = (cv::Mat_<float>(2, 4) << 1, 0, 0, 0,
+                                                         0, 1, 0, 0);
+        cv::setIdentity(KF.processNoiseCov, cv::Scalar::all(1e-2));
+        cv::setIdentity(KF.measurementNoiseCov, cv::Scalar::all(1e-2));
+        cv::setIdentity(KF.errorCovPost, cv::Scalar::all(1));
+        KF.statePost = cv::Mat::zeros(4, 1, CV_32F);
+        measurement = cv::Mat::zeros(2, 1, CV_32F);
+    }
+
+    cv::Point2f predict() {
+        cv::Mat prediction = KF.predict();
+        return cv::Point2f(prediction.at<float>(0), prediction.at<float>(1));
+    }
+
+    void correct(cv::Point2f newPosition) {
+        measurement.at<float>(0) = newPosition.x;
+        measurement.at<float>(1) = newPosition.y;
+        KF.correct(measurement);
+    }
+
+private:
+    cv::KalmanFilter KF;
+    cv::Mat measurement;
+};
+
+// One predict + correct per track, the per camera per frame workload
+template <typename Filter>
+double benchmarkTracks(const std::string& name, size_t tracks_num, long long frames) {
+    std::vector<Filter> filters(tracks_num);
+    long long frame = 0;
+    double ns = runBenchmark(name, frames, [&]() {
+        cv::Point2f measured(static_cast<float>(frame % 1280), static_cast<float>(frame % 1024));
+        for (auto& filter : filters) {
+            cv::Point2f predicted = filter.predict();
+            filter.correct(measured);
+            doNotOptimize(predicted);
+        }
+        frame++;
+    });
+    return ns / tracks_num;
+}
+
+int main(int argc, char** argv) {
+    parseBenchmarkArgs(argc, argv);
+
+    const size_t tracks_num = 4096;
+    const long long frames = 200;
+
+    std::cout << "Kalman predict+correct, " << tracks_num << " tracks per frame" << std::endl;
+    double baseline = benchmarkTracks<OpenCvKalmanFilter>("cv::KalmanFilter (per frame)", tracks_num, frames);
+    double fixed = benchmarkTracks<SimpleKalmanFilter>("FixedKalmanFilter<4,2> (per frame)", tracks_num, frames);
+
+    std::cout << "cv::KalmanFilter:        " << baseline << " ns/track" << std::endl;
+    std::cout << "FixedKalmanFilter<4,2>:  " << fixed << " ns/track" << std::endl;
+    std::cout << "Speedup: " << baseline / fixed << "x" << std::endl;
+    return finishBenchmarks();
+}
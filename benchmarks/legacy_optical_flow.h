@@ -0,0 +1,35 @@
+#ifndef LEGACY_OPTICAL_FLOW_H
+#define LEGACY_OPTICAL_FLOW_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Full frame single point optical flow the pipeline used before OpticalFlowTracker, kept as the
+// benchmarks' baseline
+cv::Point2f trackPointOpticalFlow(const cv::Mat& previous_frame, const cv::Mat& current_frame, const cv::Point2f& previous_point,
+                                  bool* found = nullptr) {
+    std::vector<cv::Point2f> previous_points(1, previous_point);
+    std::vector<cv::Point2f> current_points;
+    std::vector<uchar> status;
+    std::vector<float> err;
+
+    // Parameters for cv::calcOpticalFlowPyrLK
+    cv::Size winSize = cv::Size(128, 128);
+    int maxLevel = 2;
+    cv::TermCriteria criteria = cv::TermCriteria(cv::TermCriteria::EPS | cv::TermCriteria::COUNT, 10, 0.03);
+
+    // Calculate optical flow to get the new point position
+    cv::calcOpticalFlowPyrLK(previous_frame, current_frame, previous_points, current_points, status, err, winSize, maxLevel, criteria);
+
+    // Check if the flow was found
+    if (found) {
+        *found = status[0] == 1;
+    }
+    if (status[0] == 1) {
+        return current_points[0];
+    } else {
+        return previous_point;
+    }
+}
+
+#endif // LEGACY_OPTICAL_FLOW_H
@@ -0,0 +1,67 @@
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include "bench_utils.h"
+#include "legacy_optical_flow.h"
+#include "multi_camera_setup/camera.h"
+#include "multi_camera_setup/utils.h"
+#include "multi_camera_setup/optical_flow.h"
+
+// Function to render a textured 1280x1024 frame with the ball at the given position
+cv::Mat renderFrame(const cv::Mat& texture, const cv::Point2f& ball) {
+    cv::Mat frame = texture.clone();
+    cv::circle(frame, cv::Point(cvRound(ball.x), cvRound(ball.y)), 12, cv::Scalar(180, 60, 230), -1);
+    return frame;
+}
+
+int main(int argc, char** argv) {
+    parseBenchmarkArgs(argc, argv);
+
+    // Smooth random texture so LK has gradients everywhere
+    cv::Mat texture(1024, 1280, CV_8UC3);
+    cv::randu(texture, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::GaussianBlur(texture, texture, cv::Size(9, 9), 3.0);
+
+    const int frames_num = 64;
+    std::vector<cv::Mat> frames;
+    std::vector<cv::Mat> grays;
+    std::vector<cv::Point2f> positions;
+    for (int i = 0; i < frames_num; ++i) {
+        cv::Point2f ball(400.0f + 6.0f * i, 300.0f + 4.0f * i);
+        positions.push_back(ball);
+        frames.push_back(renderFrame(texture, ball));
+        cv::Mat gray;
+        cv::cvtColor(frames.back(), gray, cv::COLOR_BGR2GRAY);
+        grays.push_back(gray);
+    }
+
+    std::cout << "Single point optical flow per camera per frame" << std::endl;
+
+    int frame = 1;
+    runBenchmark("trackPointOpticalFlow (full frame, 128x128)", 50, [&]() {
+        cv::Point2f tracked = trackPointOpticalFlow(frames[frame - 1], frames[frame], positions[frame - 1]);
+        doNotOptimize(tracked);
+        frame = frame % (frames_num - 1) + 1;
+    });
+
+    frame = 1;
+    runBenchmark("trackPointOpticalFlow (gray full frame)", 50, [&]() {
+        cv::Point2f tracked = trackPointOpticalFlow(grays[frame - 1], grays[frame], positions[frame - 1]);
+        doNotOptimize(tracked);
+        frame = frame % (frames_num - 1) + 1;
+    });
+
+    OpticalFlowTracker tracker;
+    tracker.prepare(frames[0], positions[0]);
+    frame = 1;
+    runBenchmark("OpticalFlowTracker (ROI, reused pyramid, FB)", 2000, [&]() {
+        if (frame == 1) {
+            tracker.prepare(frames[0], positions[0]);
+        }
+        cv::Point2f tracked;
+        bool valid = tracker.track(frames[frame], positions[frame - 1], positions[frame - 1], tracked);
+        doNotOptimize(valid);
+        frame = frame % (frames_num - 1) + 1;
+    });
+    return finishBenchmarks();
+}
@@ -0,0 +1,145 @@
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench_utils.h"
+#include "multi_camera_setup/ring_queue.h"
+
+// Bounded mutex and condition variable queue, the baseline the lock-free rings replace
+template <typename T>
+class LockedQueue {
+public:
+    explicit LockedQueue(size_t capacity) : capacity(capacity) {}
+
+    bool pushBatch(T* items, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_full.wait(lock, [&] { return items_.size() < capacity || closed; });
+            if (closed) {
+                return false;
+            }
+            items_.push_back(std::move(items[i]));
+            lock.unlock();
+            not_empty.notify_one();
+        }
+        return true;
+    }
+
+    size_t popBatch(T* items, size_t max_count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [&] { return !items_.empty() || closed; });
+        size_t popped = 0;
+        while (popped < max_count && !items_.empty()) {
+            items[popped++] = std::move(items_.front());
+            items_.pop_front();
+        }
+        lock.unlock();
+        not_full.notify_all();
+        return popped;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+private:
+    size_t capacity;
+    std::deque<T> items_;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+};
+
+// Stand-in for a 2D observation handed from a camera to fusion
+struct QueueItem {
+    uint64_t sequence = 0;
+    double x = 0.0;
+    double y = 0.0;
+    int camera = 0;
+};
+
+// Function to stream items_per_producer items from each producer thread to one consumer in batches.
+// Checks every item arrives, the per producer order is kept by the rings and is not checked here.
+template <typename Queue>
+void transferItems(Queue& queue, int producers, size_t items_per_producer, size_t batch) {
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            std::vector<QueueItem> items(batch);
+            for (size_t sent = 0; sent < items_per_producer; sent += batch) {
+                size_t count = std::min(batch, items_per_producer - sent);
+                for (size_t i = 0; i < count; ++i) {
+                    items[i].sequence = sent + i;
+                    items[i].camera = p;
+                }
+                queue.pushBatch(items.data(), count);
+            }
+        });
+    }
+
+    std::vector<QueueItem> received(batch);
+    size_t total = 0, expected = items_per_producer * producers;
+    uint64_t checksum = 0;
+    while (total < expected) {
+        size_t popped = queue.popBatch(received.data(), batch);
+        for (size_t i = 0; i < popped; ++i) {
+            checksum += received[i].sequence;
+        }
+        total += popped;
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    doNotOptimize(checksum);
+}
+
+// Each op streams ITEMS items through a fresh queue of 1024 slots, thread start up included
+const size_t ITEMS = 1 << 16;
+const size_t CAPACITY = 1024;
+
+template <typename Queue>
+void runTransferBenchmark(const std::string& name, int producers, size_t batch) {
+    runBenchmark(name, 20, static_cast<double>(ITEMS * sizeof(QueueItem)), [&]() {
+        Queue queue(CAPACITY);
+        transferItems(queue, producers, ITEMS / producers, batch);
+    });
+}
+
+// Contention of the stage hand-off queues: one producer (decode to detection) and four or all cores
+// producing (cameras to fusion) into one consumer, one item or 16 at a time.
+// Usage: queue_benchmark [--quick] [--format text|csv|json] [--output file] [--baseline csv] [--tolerance x]
+int main(int argc, char** argv) {
+    parseBenchmarkArgs(argc, argv);
+    int cores = static_cast<int>(std::max(2u, std::thread::hardware_concurrency()));
+    int many = std::max(1, cores - 1);
+    std::cout << "Each op moves " << ITEMS << " items through " << CAPACITY << " slots" << std::endl;
+
+    for (size_t batch : {size_t(1), size_t(16)}) {
+        std::string suffix = ", batch " + std::to_string(batch) + ")";
+        runTransferBenchmark<SpscQueue<QueueItem, SpinWaitPolicy>>("SpscQueue spin (1 producer" + suffix, 1, batch);
+        runTransferBenchmark<SpscQueue<QueueItem, BlockingWaitPolicy>>("SpscQueue blocking (1 producer" + suffix, 1,
+                                                                        batch);
+        runTransferBenchmark<LockedQueue<QueueItem>>("LockedQueue (1 producer" + suffix, 1, batch);
+
+        std::vector<int> producer_counts = {4};
+        if (many > 4) {
+            producer_counts.push_back(many);
+        }
+        for (int producers : producer_counts) {
+            std::string label = " (" + std::to_string(producers) + " producers" + suffix;
+            runTransferBenchmark<MpscQueue<QueueItem, SpinWaitPolicy>>("MpscQueue spin" + label, producers, batch);
+            runTransferBenchmark<MpscQueue<QueueItem, BlockingWaitPolicy>>("MpscQueue blocking" + label, producers,
+                                                                            batch);
+            runTransferBenchmark<LockedQueue<QueueItem>>("LockedQueue" + label, producers, batch);
+        }
+    }
+    return finishBenchmarks();
+}
@@ -0,0 +1,251 @@
+#include <opencv2/opencv.hpp>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include "bench_utils.h"
+#include "legacy_optical_flow.h"
+#include "multi_camera_setup/camera_rig.h"
+#include "multi_camera_setup/calibration_bundle.h"
+#include "multi_camera_setup/synthetic_scene.h"
+#include "multi_camera_setup/tracking.h"
+#include "multi_camera_setup/metrics.h"
+
+// The cv::SVD DLT the fixed size kernels of dlt.h replaced, kept as the baseline
+cv::Point3d triangulatePointSvd(const std::vector<cv::Mat>& projectionMatrices, const std::vector<cv::Point2d>& imagePoints) {
+    cv::Mat A = cv::Mat::zeros(2 * (int)projectionMatrices.size(), 4, CV_64F);
+    for (int i = 0; i < (int)projectionMatrices.size(); ++i) {
+        const cv::Mat& P = projectionMatrices[i];
+        A.row(2 * i) = imagePoints[i].x * P.row(2) - P.row(0);
+        A.row(2 * i + 1) = imagePoints[i].y * P.row(2) - P.row(1);
+    }
+    cv::Mat w, u, vt;
+    cv::SVD::compute(A, w, u, vt);
+    cv::Mat point4D = vt.row(3).t();
+    return cv::Point3d(point4D.at<double>(0) / point4D.at<double>(3), point4D.at<double>(1) / point4D.at<double>(3),
+                       point4D.at<double>(2) / point4D.at<double>(3));
+}
+
+// Per stage costs of the pipeline on fixed inputs: a seeded synthetic 1280x1024 scene seen by four
+// cameras and a procedural 64 camera calibration. bytes_per_op is the input a stage reads.
+// Usage: stage_benchmark [--quick] [--format text|csv|json] [--output file] [--baseline csv] [--tolerance x]
+int main(int argc, char** argv) {
+    parseBenchmarkArgs(argc, argv);
+
+    const cv::Size frame_size(1280, 1024);
+    SyntheticSceneConfig config;
+    config.frame_size = frame_size;
+    std::vector<CameraData> cameraParams = makeProceduralRig(4, frame_size);
+    std::vector<cv::Point3d> trajectory =
+        makeBallisticTrajectory(60, config.fps, cv::Point3d(-1.0, 0.05, -1.0), cv::Point3d(0.3, 4.0, 0.3));
+    SyntheticScene scene(cameraParams, trajectory, config);
+
+    // First frame where camera 1 sees the ball, and the one before it for optical flow
+    int frame_index = 1;
+    cv::Mat previous_frame, frame;
+    while (frame_index + 1 < scene.framesNum() && !scene.render(0, frame_index, frame)) {
+        frame_index++;
+    }
+    scene.render(0, frame_index - 1, previous_frame);
+    const cv::Mat& background = scene.background(0);
+    const double frame_bytes = static_cast<double>(frame.total() * frame.elemSize());
+    const double mask_bytes = static_cast<double>(frame.total());
+
+    // Decode
+    std::vector<uchar> encoded;
+    cv::imencode(".jpg", frame, encoded);
+    runBenchmark("decode jpeg", 200, static_cast<double>(encoded.size()), [&]() {
+        cv::Mat decoded = cv::imdecode(encoded, cv::IMREAD_COLOR);
+        doNotOptimize(decoded.data);
+    });
+
+    // One directory per process, concurrent runs (ctest -j, two build trees) must not remove each other's files
+#if defined(_WIN32)
+    int pid = _getpid();
+#else
+    int pid = static_cast<int>(getpid());
+#endif
+    std::filesystem::path temp = std::filesystem::temp_directory_path() / ("mcs_stage_benchmark_" + std::to_string(pid));
+    std::filesystem::create_directories(temp);
+    std::string videoPath = (temp / "camera1.mp4").string();
+    {
+        cv::VideoWriter writer(videoPath, cv::VideoWriter::fourcc('m', 'p', '4', 'v'), config.fps, frame_size);
+        cv::Mat rendered;
+        for (int i = 0; writer.isOpened() && i < scene.framesNum(); ++i) {
+            scene.render(0, i, rendered);
+            writer.write(rendered);
+        }
+    }
+    cv::VideoCapture capture(videoPath);
+    if (capture.isOpened()) {
+        cv::Mat decoded;
+        runBenchmark("decode mp4 frame (VideoCapture)", 200, frame_bytes, [&]() {
+            if (!capture.read(decoded)) {
+                capture.set(cv::CAP_PROP_POS_FRAMES, 0);
+                capture.read(decoded);
+            }
+            doNotOptimize(decoded.data);
+        });
+    } else {
+        std::cerr << "Skipping video decode, no mp4 backend" << std::endl;
+    }
+
+    // trackerByDetection, stage by stage on the full frame
+    cv::Mat hsv, diff, gray, foreground, mask, cleaned;
+    runBenchmark("detection: BGR to HSV", 200, frame_bytes, [&]() {
+        cv::cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
+    });
+    runBenchmark("detection: absdiff background", 200, 2 * frame_bytes, [&]() {
+        cv::absdiff(frame, background, diff);
+    });
+    runBenchmark("detection: diff to gray", 200, frame_bytes, [&]() {
+        cv::cvtColor(diff, gray, cv::COLOR_BGR2GRAY);
+    });
+    runBenchmark("detection: threshold", 500, mask_bytes, [&]() {
+        cv::threshold(gray, foreground, 50, 255, cv::THRESH_BINARY);
+    });
+    runBenchmark("detection: inRange", 200, frame_bytes, [&]() {
+        cv::inRange(hsv, cv::Scalar(130, 50, 50), cv::Scalar(180, 255, 255), mask);
+    });
+    runBenchmark("detection: bitwise_and", 500, 2 * mask_bytes, [&]() {
+        cv::bitwise_and(mask, foreground, cleaned);
+    });
+    cv::Mat morphology;
+    runBenchmark("detection: dilate + erode", 200, mask_bytes, [&]() {
+        cv::dilate(cleaned, morphology, cv::Mat(), cv::Point(-1, -1), 2);
+        cv::erode(morphology, morphology, cv::Mat(), cv::Point(-1, -1), 2);
+    });
+    runBenchmark("findContoursInMask", 500, mask_bytes, [&]() {
+        std::vector<cv::Point> contour = findContoursInMask(morphology, 50.0f);
+        doNotOptimize(contour.data());
+    });
+
+    // The same mask stages on one bit per pixel, as trackerByDetection runs them
+    BitMaskWorkspace packed;
+    runBenchmark("detection: pack + and (bit mask)", 500, 2 * mask_bytes, [&]() {
+        packed.mask.packAnd(mask, foreground);
+    });
+    BitMask packedCleaned = packed.mask;
+    runBenchmark("detection: dilate + erode (bit mask)", 500, mask_bytes / 8, [&]() {
+        packed.mask.bits = packedCleaned.bits;
+        closeBitMask(packed.mask, packed.scratch, 2);
+    });
+    runBenchmark("findLargestMaskBlob (bit mask)", 500, mask_bytes / 8, [&]() {
+        MaskBlob blob;
+        bool found = findLargestMaskBlob(packed, 50.0f, blob);
+        doNotOptimize(found);
+    });
+
+    CameraRig rig(cameraParams);
+    Camera& camera = rig.cameras[0];
+    camera.setBackground(background);
+    DetectionParams untiled;
+    untiled.tile_rows = 0;
+    runBenchmark("trackerByDetection (full frame)", 100, frame_bytes, [&]() {
+        frame.copyTo(camera.current_frame);
+        trackerByDetection(camera, untiled);
+        doNotOptimize(camera.state->current_tracker_position);
+    });
+    runBenchmark("trackerByDetection (full frame, 128 row tiles)", 100, frame_bytes, [&]() {
+        frame.copyTo(camera.current_frame);
+        trackerByDetection(camera);
+        doNotOptimize(camera.state->current_tracker_position);
+    });
+
+    cv::Point2f ball = camera.state->current_tracker_position;
+    runBenchmark("trackPointOpticalFlow (full frame)", 50, 2 * frame_bytes, [&]() {
+        cv::Point2f tracked = trackPointOpticalFlow(previous_frame, frame, ball);
+        doNotOptimize(tracked);
+    });
+
+    // Geometry and filtering
+    runBenchmark("getProjectionMatrix", 20000, [&]() {
+        cv::Mat P = camera.getProjectionMatrix();
+        doNotOptimize(P.data);
+    });
+
+    std::vector<cv::Mat> projectionMatrices = getProjectionMatrices(rig.cameras);
+    std::vector<cv::Point2d> imagePoints;
+    for (const cv::Mat& P : projectionMatrices) {
+        cv::Mat X = (cv::Mat_<double>(4, 1) << trajectory[frame_index].x, trajectory[frame_index].y,
+                     trajectory[frame_index].z, 1.0);
+        cv::Mat x = P * X;
+        imagePoints.emplace_back(x.at<double>(0) / x.at<double>(2), x.at<double>(1) / x.at<double>(2));
+    }
+    TriangulationQuality quality;
+    runBenchmark("triangulatePoint (4 cameras)", 20000, [&]() {
+        cv::Point3d point = triangulatePoint(projectionMatrices, imagePoints, &quality);
+        doNotOptimize(point);
+    });
+
+    // DLT kernels alone: fixed size, dynamic and the cv::SVD baseline, on a 4 and a 16 camera rig
+    for (int cameras_num : {4, 16}) {
+        CameraRig dltRig(makeProceduralRig(cameras_num, frame_size));
+        CameraGeometryBlock& dltGeometry = dltRig.geometry;
+        dltGeometry.setProjectionMatrices(getProjectionMatrices(dltRig.cameras));
+        for (int i = 0; i < cameras_num; ++i) {
+            cv::Vec3d x = dltGeometry.projections[i] *
+                          cv::Vec4d(trajectory[frame_index].x, trajectory[frame_index].y, trajectory[frame_index].z, 1.0);
+            dltGeometry.image_points[i] = cv::Point2d(x[0] / x[2], x[1] / x[2]);
+        }
+        std::string suffix = " (" + std::to_string(cameras_num) + " cameras)";
+        cv::Vec4d singularValues;
+        runBenchmark("DLT fixed size kernel" + suffix, 200000, [&]() {
+            cv::Point3d point = dltGeometry.dlt_kernel(dltGeometry.projections.data(), dltGeometry.image_points.data(),
+                                                       dltGeometry.size(), singularValues);
+            doNotOptimize(point);
+        });
+        runBenchmark("DLT dynamic kernel" + suffix, 200000, [&]() {
+            cv::Point3d point = triangulateDltDynamic(dltGeometry.projections.data(), dltGeometry.image_points.data(),
+                                                      dltGeometry.size(), singularValues);
+            doNotOptimize(point);
+        });
+        runBenchmark("DLT cv::SVD" + suffix, 20000, [&]() {
+            cv::Point3d point = triangulatePointSvd(dltGeometry.projection_matrices, dltGeometry.image_points);
+            doNotOptimize(point);
+        });
+    }
+
+    SimpleKalmanFilter kalman;
+    int step = 0;
+    runBenchmark("SimpleKalmanFilter predict + correct", 1000000, [&]() {
+        cv::Point2f predicted = kalman.predict();
+        kalman.correct(cv::Point2f(100.0f + step, 200.0f + 0.5f * step));
+        doNotOptimize(predicted);
+        step = (step + 1) & 1023;
+    });
+
+    // Calibration loading for a 64 camera rig
+    std::string jsonPath = (temp / "cameras.json").string();
+    std::string bundlePath = (temp / "cameras.bundle").string();
+    saveCameraParamsToJson(makeProceduralRig(64, frame_size), jsonPath);
+    std::streambuf* console = std::cout.rdbuf(nullptr); // The compiler reports what it wrote
+    compileCalibrationBundle(jsonPath, bundlePath);
+    std::cout.rdbuf(console);
+    double json_bytes = static_cast<double>(std::filesystem::file_size(jsonPath));
+    runBenchmark("loadCameraParamsFromJson (64 cameras)", 200, json_bytes, [&]() {
+        std::vector<CameraData> loaded = loadCameraParamsFromJson(jsonPath);
+        doNotOptimize(loaded.data());
+    });
+    runBenchmark("CalibrationBundle open (64 cameras)", 2000, [&]() {
+        CalibrationBundle bundle;
+        bool opened = bundle.open(bundlePath);
+        doNotOptimize(opened);
+    });
+
+    // Instrumentation cost of one stage scope, compare with the stages above (MCS_ENABLE_METRICS/TRACING builds)
+    PipelineMetrics::instance().configure(static_cast<int>(rig.cameras.size()));
+    PipelineTracer::instance().enable(1 << 16);
+    runBenchmark("stage scope (metrics + trace)", 1000000, [&]() {
+        ScopedStageTimer timer(Stage::Detection, 1);
+        doNotOptimize(timer);
+    });
+
+    std::filesystem::remove_all(temp);
+    return finishBenchmarks();
+}
@@ -0,0 +1,47 @@
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <tbb/parallel_for.h>
+#include "bench_utils.h"
+#include "multi_camera_setup/synthetic_scene.h"
+
+// Usage: synthetic_scene_benchmark [cameras] [width] [height], defaults to 64 cameras at 4K
+int main(int argc, char** argv) {
+    int cameras_num = argc > 1 ? std::stoi(argv[1]) : 64;
+    cv::Size frame_size(argc > 2 ? std::stoi(argv[2]) : 3840, argc > 3 ? std::stoi(argv[3]) : 2160);
+
+    SyntheticSceneConfig config;
+    config.frame_size = frame_size;
+    config.noise_variants = 1; // Keeps 64 4K cameras within a few GB
+
+    std::vector<cv::Point3d> trajectory =
+        makeBallisticTrajectory(300, config.fps, cv::Point3d(-1.0, 0.05, -1.0), cv::Point3d(0.3, 4.0, 0.3));
+
+    auto start = std::chrono::steady_clock::now();
+    SyntheticScene scene(makeProceduralRig(cameras_num, frame_size), trajectory, config);
+    std::cout << "Prepared " << cameras_num << " cameras at " << frame_size << " in "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms"
+              << std::endl;
+
+    std::vector<cv::Mat> frames(cameras_num);
+    int frame_index = 0;
+
+    runBenchmark("render one camera frame", 200, [&]() {
+        scene.render(0, frame_index, frames[0]);
+        doNotOptimize(frames[0].data);
+        frame_index = (frame_index + 1) % scene.framesNum();
+    });
+
+    frame_index = 0;
+    double rig_ns = runBenchmark("render all cameras (parallel)", 20, [&]() {
+        tbb::parallel_for(size_t(0), static_cast<size_t>(cameras_num), [&](size_t i) {
+            scene.render(i, frame_index, frames[i]);
+        });
+        doNotOptimize(frames[0].data);
+        frame_index = (frame_index + 1) % scene.framesNum();
+    });
+    std::cout << "Rig frames per second: " << 1e9 / rig_ns << std::endl;
+    return 0;
+}
@@ -0,0 +1,359 @@
+#ifndef BIT_MASK_H
+#define BIT_MASK_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Function to count the set bits of a word
+inline int popcount64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<int>(__popcnt64(word));
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ull);
+    word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+    word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return static_cast<int>((word * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+// Function to get the index of the lowest set bit, word must not be 0
+inline int ctz64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    int index = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+// Binary image at one bit per pixel, 64 pixels per word and each row padded to whole words.
+// Bit b of word w in a row is column 64 * w + b. Padding bits past the last column are always clear.
+class BitMask {
+public:
+    int rows = 0;
+    int cols = 0;
+    int words = 0; // Words per row
+    std::vector<uint64_t> bits;
+
+    // Method to size the mask, reusing the storage, the contents are undefined afterwards
+    void create(int new_rows, int new_cols) {
+        rows = new_rows;
+        cols = new_cols;
+        words = (cols + 63) / 64;
+        bits.resize(static_cast<size_t>(rows) * words);
+    }
+
+    bool empty() const { return rows == 0 || cols == 0; }
+
+    uint64_t* row(int r) { return bits.data() + static_cast<size_t>(r) * words; }
+    const uint64_t* row(int r) const { return bits.data() + static_cast<size_t>(r) * words; }
+
+    // Valid bits of the last word of a row
+    uint64_t lastWordMask() const {
+        int tail = cols & 63;
+        return tail ? (uint64_t(1) << tail) - 1 : ~uint64_t(0);
+    }
+
+    // Method to pack the AND of two 8 bit masks of 0 and 255, the bitwise_and is fused into the packing
+    void packAnd(const cv::Mat& a, const cv::Mat& b) {
+        create(a.rows, a.cols);
+        packAndRows(a, b, 0);
+    }
+
+    // Method to pack the AND of two 8 bit masks into rows [first_row, first_row + a.rows) of this mask
+    void packAndRows(const cv::Mat& a, const cv::Mat& b, int first_row) {
+        CV_Assert(a.type() == CV_8UC1 && b.type() == CV_8UC1 && a.size() == b.size());
+        CV_Assert(a.cols == cols && first_row >= 0 && first_row + a.rows <= rows);
+        for (int r = 0; r < a.rows; ++r) {
+            const uchar* pa = a.ptr<uchar>(r);
+            const uchar* pb = b.ptr<uchar>(r);
+            uint64_t* out = row(first_row + r);
+            for (int w = 0; w < words; ++w) {
+                int x0 = w * 64;
+                int n = std::min(64, cols - x0);
+                uint64_t word = 0;
+                int i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    uint64_t va, vb;
+                    std::memcpy(&va, pa + x0 + i, 8);
+                    std::memcpy(&vb, pb + x0 + i, 8);
+                    word |= packByteMsbs(va & vb) << i;
+                }
+                for (; i < n; ++i) {
+                    word |= static_cast<uint64_t>((pa[x0 + i] & pb[x0 + i]) >> 7) << i;
+                }
+                out[w] = word;
+            }
+        }
+    }
+
+    void pack(const cv::Mat& mask) { packAnd(mask, mask); }
+
+    // Method to copy count rows of a mask of the same width, starting at src_row, to dst_row
+    void copyRows(const BitMask& src, int src_row, int dst_row, int count) {
+        CV_Assert(src.words == words && src_row + count <= src.rows && dst_row + count <= rows);
+        std::memcpy(row(dst_row), src.row(src_row), static_cast<size_t>(count) * words * sizeof(uint64_t));
+    }
+
+    // Method to expand back to an 8 bit mask of 0 and 255, for display and debugging
+    void unpack(cv::Mat& mask) const {
+        mask.create(rows, cols, CV_8UC1);
+        for (int r = 0; r < rows; ++r) {
+            const uint64_t* in = row(r);
+            uchar* out = mask.ptr<uchar>(r);
+            for (int x = 0; x < cols; ++x) {
+                out[x] = ((in[x >> 6] >> (x & 63)) & 1) ? 255 : 0;
+            }
+        }
+    }
+
+    // Method to count the set pixels
+    size_t count() const {
+        size_t total = 0;
+        for (uint64_t word : bits) {
+            total += static_cast<size_t>(popcount64(word));
+        }
+        return total;
+    }
+
+private:
+    // Gathers the top bit of each byte of a little endian load, byte i to bit i. The multiply moves
+    // the eight bits to the top byte without any two partial products overlapping.
+    static uint64_t packByteMsbs(uint64_t v) {
+        return (((v & 0x8080808080808080ull) >> 7) * 0x0102040810204080ull) >> 56;
+    }
+};
+
+// Horizontal run of set pixels [x0, x1) in one row
+struct MaskRun {
+    int row;
+    int x0;
+    int x1;
+};
+
+// 8-connected component of a bit mask
+struct MaskBlob {
+    int area = 0; // Set pixels
+    cv::Rect bounds;
+};
+
+// Rows of a mask processed by one task, halo included
+struct BitMaskTile {
+    BitMask mask;
+    BitMask scratch;
+};
+
+// Buffers of the bit mask detection, kept per camera so tracking does not allocate after the first frame
+struct BitMaskWorkspace {
+    BitMask mask;
+    BitMask scratch; // Horizontal pass of the morphology
+    std::vector<BitMaskTile> tiles; // Row tiles of a tiled detection
+    std::vector<MaskRun> runs;
+    std::vector<int> row_start; // First run of each row, rows + 1 entries
+    std::vector<int> parent; // Union-find over runs
+    std::vector<int> blob_of_root;
+    std::vector<MaskBlob> blobs;
+    std::vector<cv::Point> points; // Run ends of the selected blob
+};
+
+// Function to dilate with a 3x3 square, pixels outside the image are clear (cv::dilate's default border)
+inline void dilateBitMask3x3(BitMask& mask, BitMask& scratch) {
+    scratch.create(mask.rows, mask.cols);
+    const int words = mask.words;
+    const uint64_t last = mask.lastWordMask();
+    for (int r = 0; r < mask.rows; ++r) {
+        const uint64_t* in = mask.row(r);
+        uint64_t* out = scratch.row(r);
+        for (int w = 0; w < words; ++w) {
+            uint64_t previous = w > 0 ? in[w - 1] : 0;
+            uint64_t next = w + 1 < words ? in[w + 1] : 0;
+            uint64_t cur = in[w];
+            out[w] = cur | (cur << 1) | (previous >> 63) | (cur >> 1) | (next << 63);
+        }
+        out[words - 1] &= last;
+    }
+    for (int r = 0; r < mask.rows; ++r) {
+        const uint64_t* above = scratch.row(r > 0 ? r - 1 : r);
+        const uint64_t* center = scratch.row(r);
+        const uint64_t* below = scratch.row(r + 1 < mask.rows ? r + 1 : r);
+        uint64_t* out = mask.row(r);
+        for (int w = 0; w < words; ++w) {
+            out[w] = above[w] | center[w] | below[w];
+        }
+    }
+}
+
+// Function to erode with a 3x3 square, pixels outside the image are set (cv::erode's default border)
+inline void erodeBitMask3x3(BitMask& mask, BitMask& scratch) {
+    scratch.create(mask.rows, mask.cols);
+    const int words = mask.words;
+    const uint64_t last = mask.lastWordMask();
+    for (int r = 0; r < mask.rows; ++r) {
+        uint64_t* in = mask.row(r);
+        uint64_t* out = scratch.row(r);
+        in[words - 1] |= ~last; // The right border counts as set
+        for (int w = 0; w < words; ++w) {
+            uint64_t previous = w > 0 ? in[w - 1] : ~uint64_t(0);
+            uint64_t next = w + 1 < words ? in[w + 1] : ~uint64_t(0);
+            uint64_t cur = in[w];
+            out[w] = cur & ((cur << 1) | (previous >> 63)) & ((cur >> 1) | (next << 63));
+        }
+        out[words - 1] &= last;
+    }
+    for (int r = 0; r < mask.rows; ++r) {
+        const uint64_t* above = scratch.row(r > 0 ? r - 1 : r);
+        const uint64_t* center = scratch.row(r);
+        const uint64_t* below = scratch.row(r + 1 < mask.rows ? r + 1 : r);
+        uint64_t* out = mask.row(r);
+        for (int w = 0; w < words; ++w) {
+            out[w] = above[w] & center[w] & below[w];
+        }
+    }
+}
+
+// Function to close small gaps like dilate then erode with cv::Mat() and the given iterations
+inline void closeBitMask(BitMask& mask, BitMask& scratch, int iterations) {
+    if (mask.empty()) {
+        return;
+    }
+    for (int i = 0; i < iterations; ++i) {
+        dilateBitMask3x3(mask, scratch);
+    }
+    for (int i = 0; i < iterations; ++i) {
+        erodeBitMask3x3(mask, scratch);
+    }
+}
+
+// Function to list the runs of set pixels row by row, finding run ends a word at a time
+inline void extractMaskRuns(const BitMask& mask, std::vector<MaskRun>& runs, std::vector<int>& row_start) {
+    runs.clear();
+    row_start.assign(static_cast<size_t>(mask.rows) + 1, 0);
+    for (int r = 0; r < mask.rows; ++r) {
+        row_start[r] = static_cast<int>(runs.size());
+        const uint64_t* in = mask.row(r);
+        int x = 0;
+        while (x < mask.cols) {
+            // Next set bit from x
+            int w = x >> 6;
+            uint64_t word = in[w] & (~uint64_t(0) << (x & 63));
+            while (word == 0 && ++w < mask.words) {
+                word = in[w];
+            }
+            if (word == 0) {
+                break;
+            }
+            int x0 = w * 64 + ctz64(word);
+
+            // Next clear bit from x0, the clear padding ends a run at the last column at the latest
+            w = x0 >> 6;
+            word = ~in[w] & (~uint64_t(0) << (x0 & 63));
+            while (word == 0 && ++w < mask.words) {
+                word = ~in[w];
+            }
+            int x1 = word == 0 ? mask.cols : std::min(mask.cols, w * 64 + ctz64(word));
+            runs.push_back(MaskRun{r, x0, x1});
+            x = x1;
+        }
+    }
+    row_start[mask.rows] = static_cast<int>(runs.size());
+}
+
+// Function to label the 8-connected blobs of workspace.mask into workspace.blobs, by union-find over
+// the runs of consecutive rows
+inline void labelMaskBlobs(BitMaskWorkspace& workspace) {
+    std::vector<MaskRun>& runs = workspace.runs;
+    std::vector<int>& parent = workspace.parent;
+    extractMaskRuns(workspace.mask, runs, workspace.row_start);
+
+    parent.resize(runs.size());
+    for (size_t i = 0; i < runs.size(); ++i) {
+        parent[i] = static_cast<int>(i);
+    }
+    auto find = [&](int i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+
+    for (int r = 1; r < workspace.mask.rows; ++r) {
+        int i = workspace.row_start[r - 1], i_end = workspace.row_start[r];
+        int j = workspace.row_start[r], j_end = workspace.row_start[r + 1];
+        while (i < i_end && j < j_end) {
+            // Touching or diagonal neighbours
+            if (runs[i].x0 <= runs[j].x1 && runs[j].x0 <= runs[i].x1) {
+                int a = find(i), b = find(j);
+                parent[std::max(a, b)] = std::min(a, b);
+            }
+            if (runs[i].x1 < runs[j].x1) {
+                ++i;
+            } else {
+                ++j;
+            }
+        }
+    }
+
+    workspace.blobs.clear();
+    workspace.blob_of_root.assign(runs.size(), -1);
+    for (size_t i = 0; i < runs.size(); ++i) {
+        int root = find(static_cast<int>(i));
+        parent[i] = root;
+        int& blob = workspace.blob_of_root[root];
+        cv::Rect run(runs[i].x0, runs[i].row, runs[i].x1 - runs[i].x0, 1);
+        if (blob < 0) {
+            blob = static_cast<int>(workspace.blobs.size());
+            workspace.blobs.push_back(MaskBlob{0, run});
+        }
+        workspace.blobs[blob].area += run.width;
+        workspace.blobs[blob].bounds |= run;
+    }
+}
+
+// Function to find the largest blob above minArea pixels. Its run ends go to workspace.points: they
+// include every vertex of the blob's convex hull, so their enclosing circle is the blob's.
+inline bool findLargestMaskBlob(BitMaskWorkspace& workspace, float minArea, MaskBlob& largest) {
+    workspace.points.clear();
+    if (workspace.mask.empty() || static_cast<float>(workspace.mask.count()) <= minArea) {
+        return false; // Not enough pixels for any blob
+    }
+    labelMaskBlobs(workspace);
+
+    int best = -1;
+    for (size_t i = 0; i < workspace.blobs.size(); ++i) {
+        if (static_cast<float>(workspace.blobs[i].area) > minArea &&
+            (best < 0 || workspace.blobs[i].area > workspace.blobs[best].area)) {
+            best = static_cast<int>(i);
+        }
+    }
+    if (best < 0) {
+        return false;
+    }
+    largest = workspace.blobs[best];
+    for (size_t i = 0; i < workspace.runs.size(); ++i) {
+        if (workspace.blob_of_root[workspace.parent[i]] == best) {
+            const MaskRun& run = workspace.runs[i];
+            workspace.points.emplace_back(run.x0, run.row);
+            workspace.points.emplace_back(run.x1 - 1, run.row);
+        }
+    }
+    return true;
+}
+
+#endif // BIT_MASK_H
@@ -0,0 +1,250 @@
+#ifndef CALIBRATION_BUNDLE_H
+#define CALIBRATION_BUNDLE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "camera_parameters.h"
+#include "mapped_file.h"
+
+// Binary calibration bundle, written by compileCalibrationBundle and mapped by CalibrationBundle.
+// Layout in native byte order: BundleHeader, then cameras_num BundleCamera records. Every record
+// is a multiple of 8 bytes so all doubles stay aligned in the mapping. Only what a run reads is
+// stored, the calibration and the projection matrices derived from it.
+struct BundleHeader {
+    char magic[8]; // "MCSCALB"
+    uint32_t version;
+    uint32_t byte_order; // 0x01020304 as stored by the writer
+    uint32_t cameras_num;
+    uint32_t reserved;
+    uint64_t cameras_offset;
+    uint64_t file_size;
+};
+
+// Calibration and projection matrix of one camera
+struct BundleCamera {
+    char name[64]; // Null terminated
+    double K[9];
+    double rvec[3];
+    double tvec[3];
+    double P[12]; // K * [R|t]
+    double dist[8];
+    uint32_t dist_size;
+    uint32_t reserved;
+};
+
+static_assert(std::is_trivially_copyable<BundleHeader>::value && sizeof(BundleHeader) % 8 == 0, "bundle layout");
+static_assert(std::is_trivially_copyable<BundleCamera>::value && sizeof(BundleCamera) % 8 == 0, "bundle layout");
+
+const char CALIBRATION_BUNDLE_MAGIC[8] = {'M', 'C', 'S', 'C', 'A', 'L', 'B', '\0'};
+const uint32_t CALIBRATION_BUNDLE_VERSION = 2; // 1 also held inverse intrinsics and per pair geometry
+const uint32_t CALIBRATION_BUNDLE_BYTE_ORDER = 0x01020304;
+
+// Function to check camera parameters before compiling them, every problem is reported
+bool validateCameraData(const std::vector<CameraData>& cameraParams) {
+    bool valid = true;
+    auto fail = [&](const std::string& name, const std::string& message) {
+        std::cerr << "Invalid calibration of camera " << name << ": " << message << std::endl;
+        valid = false;
+    };
+
+    if (cameraParams.empty()) {
+        std::cerr << "Invalid calibration: no cameras" << std::endl;
+        return false;
+    }
+
+    std::set<std::string> names;
+    for (const CameraData& camera : cameraParams) {
+        if (camera.name.empty() || camera.name.size() >= sizeof(BundleCamera::name)) {
+            fail(camera.name, "name must have 1 to 63 characters");
+        }
+        if (!names.insert(camera.name).second) {
+            fail(camera.name, "duplicate name");
+        }
+        if (camera.rvec.size() != 3 || camera.tvec.size() != 3) {
+            fail(camera.name, "rvec and tvec need 3 values");
+        }
+        if (camera.K.size() != 3 || camera.K[0].size() != 3 || camera.K[1].size() != 3 || camera.K[2].size() != 3) {
+            fail(camera.name, "K must be 3x3");
+            continue;
+        }
+        if (!(camera.K[0][0] > 0.0 && camera.K[1][1] > 0.0)) {
+            fail(camera.name, "focal lengths must be positive");
+        }
+        if (camera.K[2][0] != 0.0 || camera.K[2][1] != 0.0 || camera.K[2][2] != 1.0) {
+            fail(camera.name, "last row of K must be (0, 0, 1)");
+        }
+        auto finite = [](const std::vector<double>& values) {
+            for (double value : values) {
+                if (!std::isfinite(value)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        if (!finite(camera.rvec) || !finite(camera.tvec) || !finite(camera.dist) ||
+            !finite(camera.K[0]) || !finite(camera.K[1])) {
+            fail(camera.name, "non finite value");
+        }
+    }
+    return valid;
+}
+
+// Function to fill the per camera record with the calibration and its projection matrix
+BundleCamera makeBundleCamera(const CameraData& data) {
+    BundleCamera camera{};
+    std::strncpy(camera.name, data.name.c_str(), sizeof(camera.name) - 1);
+
+    cv::Matx33d K;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            K(i, j) = data.K[i][j];
+        }
+    }
+    cv::Matx31d rvec(data.rvec[0], data.rvec[1], data.rvec[2]);
+    cv::Matx31d tvec(data.tvec[0], data.tvec[1], data.tvec[2]);
+    cv::Matx33d R;
+    cv::Rodrigues(rvec, R);
+    cv::Matx34d Rt(R(0, 0), R(0, 1), R(0, 2), tvec(0),
+                   R(1, 0), R(1, 1), R(1, 2), tvec(1),
+                   R(2, 0), R(2, 1), R(2, 2), tvec(2));
+    cv::Matx34d P = K * Rt;
+
+    std::memcpy(camera.K, K.val, sizeof(camera.K));
+    std::memcpy(camera.rvec, rvec.val, sizeof(camera.rvec));
+    std::memcpy(camera.tvec, tvec.val, sizeof(camera.tvec));
+    std::memcpy(camera.P, P.val, sizeof(camera.P));
+    camera.dist_size = static_cast<uint32_t>(data.dist.size());
+    std::copy(data.dist.begin(), data.dist.end(), camera.dist);
+    return camera;
+}
+
+// Function to validate cameras.json and write the binary bundle, returns false without writing on error
+bool compileCalibrationBundle(const std::string& jsonFilePath, const std::string& bundlePath) {
+    std::vector<CameraData> cameraParams = loadCameraParamsFromJson(jsonFilePath);
+    if (!validateCameraData(cameraParams)) {
+        return false;
+    }
+
+    const size_t cameras_num = cameraParams.size();
+    std::vector<BundleCamera> cameras;
+    for (const CameraData& data : cameraParams) {
+        cameras.push_back(makeBundleCamera(data));
+    }
+
+    BundleHeader header{};
+    std::memcpy(header.magic, CALIBRATION_BUNDLE_MAGIC, sizeof(header.magic));
+    header.version = CALIBRATION_BUNDLE_VERSION;
+    header.byte_order = CALIBRATION_BUNDLE_BYTE_ORDER;
+    header.cameras_num = static_cast<uint32_t>(cameras_num);
+    header.cameras_offset = sizeof(BundleHeader);
+    header.file_size = header.cameras_offset + cameras_num * sizeof(BundleCamera);
+
+    std::ofstream file(bundlePath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Could not write calibration bundle: " << bundlePath << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(cameras.data()), cameras.size() * sizeof(BundleCamera));
+    if (!file) {
+        std::cerr << "Could not write calibration bundle: " << bundlePath << std::endl;
+        return false;
+    }
+
+    std::cout << "Compiled " << cameras_num << " cameras into " << bundlePath << " (" << header.file_size
+              << " bytes)" << std::endl;
+    return true;
+}
+
+// Read-only view of a memory mapped calibration bundle, the records are used in place
+class CalibrationBundle {
+public:
+    // Method to map and check a bundle, returns false (and reports why) if it is not usable
+    bool open(const std::string& bundlePath) {
+        if (!file.open(bundlePath)) {
+            return false;
+        }
+        auto reject = [&](const std::string& reason) {
+            std::cerr << "Invalid calibration bundle " << bundlePath << ": " << reason << std::endl;
+            file.close();
+            header = nullptr;
+            return false;
+        };
+
+        if (file.size() < sizeof(BundleHeader)) {
+            return reject("truncated header");
+        }
+        header = reinterpret_cast<const BundleHeader*>(file.data());
+        if (std::memcmp(header->magic, CALIBRATION_BUNDLE_MAGIC, sizeof(header->magic)) != 0) {
+            return reject("bad magic");
+        }
+        if (header->version != CALIBRATION_BUNDLE_VERSION) {
+            return reject("unsupported version " + std::to_string(header->version));
+        }
+        if (header->byte_order != CALIBRATION_BUNDLE_BYTE_ORDER) {
+            return reject("written on a machine with a different byte order");
+        }
+        uint64_t cameras_num = header->cameras_num;
+        if (header->file_size != file.size() ||
+            header->cameras_offset != sizeof(BundleHeader) ||
+            header->file_size != header->cameras_offset + cameras_num * sizeof(BundleCamera)) {
+            return reject("inconsistent size");
+        }
+
+        cameras = reinterpret_cast<const BundleCamera*>(file.data() + header->cameras_offset);
+        for (size_t i = 0; i < cameras_num; ++i) {
+            if (cameras[i].name[sizeof(BundleCamera::name) - 1] != '\0' || cameras[i].dist_size > 8) {
+                return reject("corrupt camera record " + std::to_string(i));
+            }
+        }
+        return true;
+    }
+
+    bool isOpen() const { return header != nullptr; }
+    size_t camerasNum() const { return header ? header->cameras_num : 0; }
+    const BundleCamera& camera(size_t i) const { return cameras[i]; }
+
+    cv::Matx34d projection(size_t i) const { return cv::Matx34d(cameras[i].P); }
+
+    // Method to get the projection matrices in the form triangulatePoint expects
+    std::vector<cv::Mat> projectionMatrices() const {
+        std::vector<cv::Mat> matrices;
+        for (size_t i = 0; i < camerasNum(); ++i) {
+            matrices.push_back(cv::Mat(3, 4, CV_64F, const_cast<double*>(cameras[i].P)).clone());
+        }
+        return matrices;
+    }
+
+    // Method to get the calibration in the same form as loadCameraParamsFromJson
+    std::vector<CameraData> cameraData() const {
+        std::vector<CameraData> cameraParams(camerasNum());
+        for (size_t i = 0; i < camerasNum(); ++i) {
+            const BundleCamera& camera = cameras[i];
+            CameraData& data = cameraParams[i];
+            data.name = camera.name;
+            data.tvec.assign(camera.tvec, camera.tvec + 3);
+            data.rvec.assign(camera.rvec, camera.rvec + 3);
+            data.K = {{camera.K[0], camera.K[1], camera.K[2]},
+                      {camera.K[3], camera.K[4], camera.K[5]},
+                      {camera.K[6], camera.K[7], camera.K[8]}};
+            data.dist.assign(camera.dist, camera.dist + camera.dist_size);
+        }
+        return cameraParams;
+    }
+
+private:
+    MappedFile file;
+    const BundleHeader* header = nullptr;
+    const BundleCamera* cameras = nullptr;
+};
+
+#endif // CALIBRATION_BUNDLE_H
@@ -1,39 +1,50 @@
 #ifndef CAMERA_H
 #define CAMERA_H
 
+#include <deque>
+#include <memory>
 #include <string>
 #include <opencv2/opencv.hpp>
-#include "kalman.h"
-
+#include "camera_state.h"
+#include "undistort.h"
+#include "optical_flow.h"
+#include "correlation_tracker.h"
+#include "frame_source.h"
+#include "bit_mask.h"
 
+// Cold per camera data: calibration, video, images and the tracker buffers. The hot per frame
+// tracking state lives in a CameraTrackState owned by the rig, see camera_state.h.
 class Camera {
 public:
     std::string name;
     std::vector<double> tvec; // Translation vector
     std::vector<double> rvec; // Rotation vector
     std::vector<std::vector<double>> K; // Intrinsic matrix
+    std::vector<double> dist; // Distortion coefficients
+    PointUndistorter undistorter; // Undistorts detected points, frames stay raw
     cv::Mat current_frame; // Current video frame
     cv::Mat background; // Background image
     cv::VideoCapture capture; // Video capture object
-    cv::Point2f current_tracker_position; // Center of the ball
-    cv::Point2f previous_tracker_position; // Previous center of the ball
-    cv::Point2f tracker_speed; // 2D speed of the ball
-
-    SimpleKalmanFilter kalman_fitler; // Kalman filter ovject
-
-
+    std::shared_ptr<FrameSource> frame_source; // In memory frames, replaces the capture when set
+    std::deque<cv::Mat> prefetched_frames; // Frames decoded ahead of time, consumed before the capture
+    int frame_count = 0; // Frames in the video, from probeVideo
+    double frame_rate = 0.0; // Frames per second, from probeVideo
+    OpticalFlowTracker flow_tracker; // Lucas-Kanade tracker between detections
+    CorrelationTracker correlation_tracker; // Correlation filter alternative to the flow tracker
+    BitMaskWorkspace detection_mask; // Bit packed detection mask and its labeling buffers
+    CameraTrackState* state; // Hot tracking state, owned by the rig
 
     int index; // Index of the camera
-    bool is_detection_active = false;
-    bool is_detection_valid = false;
 
     Camera(const std::string& name, 
            const std::vector<double>& tvec, 
            const std::vector<double>& rvec, 
            const std::vector<std::vector<double>>& K,
-           const int index)
-    : name(name), tvec(tvec), rvec(rvec), K(K),index(index) {
-        kalman_fitler.initKalmanFilter();
+           const std::vector<double>& dist,
+           const int index,
+           CameraTrackState& state)
+    : name(name), tvec(tvec), rvec(rvec), K(K), dist(dist), undistorter(K, dist), state(&state), index(index) {
+        state.kalman_fitler.initKalmanFilter();
     }
 
     // Method to open video file
@@ -46,8 +57,41 @@ public:
         return true;
     }
 
+    // Method to read the container properties once, so later code does not query the capture
+    void probeVideo() {
+        frame_count = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_COUNT));
+        frame_rate = capture.get(cv::CAP_PROP_FPS);
+    }
+
+    // Method to read frames from an in memory source instead of a video file
+    void setFrameSource(std::shared_ptr<FrameSource> source) {
+        frame_source = std::move(source);
+        frame_count = frame_source->frameCount();
+        frame_rate = frame_source->frameRate();
+    }
+
+    // Method to decode up to count frames ahead, returns the number of frames decoded
+    int prefetchFrames(int count) {
+        int decoded = 0;
+        cv::Mat frame;
+        while (decoded < count && capture.isOpened() && capture.read(frame)) {
+            prefetched_frames.push_back(frame);
+            frame = cv::Mat(); // Let the next read allocate instead of overwriting the stored frame
+            decoded++;
+        }
+        return decoded;
+    }
+
     // Method to read the next frame from the video
     bool readNextFrame() {
+        if (!prefetched_frames.empty()) {
+            current_frame = std::move(prefetched_frames.front());
+            prefetched_frames.pop_front();
+            return true;
+        }
+        if (frame_source) {
+            return frame_source->read(current_frame);
+        }
         if (!capture.isOpened()) {
             std::cerr << "Video file not opened." << std::endl;
             return false;
@@ -62,9 +106,25 @@ public:
         }
     }
 
-    // Method to set the background image
-    void setBackground(const cv::Mat& bg) {
-        background = bg.clone();
+    // Method to set the background image, the camera shares bg's pixels instead of copying them
+    void setBackground(cv::Mat bg) {
+        background = std::move(bg);
+    }
+
+    // Method to check that the given tracker between detections has a reference to track from
+    bool canTrackWith(TrackerMode mode) const {
+        if (!state->is_tracking) {
+            return false;
+        }
+        if (mode == TrackerMode::CorrelationFilter) {
+            return correlation_tracker.isInitialized();
+        }
+        return flow_tracker.hasPrevious();
+    }
+
+    // Method to get the undistorted tracker position used for triangulation
+    cv::Point2d getUndistortedTrackerPosition() const {
+        return undistorter.undistort(state->current_tracker_position);
     }
 
 // Method to get projection matrix
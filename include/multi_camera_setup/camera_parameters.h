@@ -16,6 +16,7 @@ struct CameraData {
     std::vector<double> tvec; // Translation vector
     std::vector<double> rvec; // Rotation vector
     std::vector<std::vector<double>> K; // Intrinsic matrix
+    std::vector<double> dist; // Distortion coefficients (k1, k2, p1, p2[, k3[, k4, k5, k6]]), empty if none
 };
 
 // Function to load camera parameters from a JSON file
@@ -42,10 +43,48 @@ std::vector<CameraData> loadCameraParamsFromJson(const std::string& jsonFilePath
             cameraData.K.push_back(row.get<std::vector<double>>());
         }
 
+        // Optional distortion coefficients, flat or nested like rvec
+        if (cameraItem.contains("dist")) {
+            const json& distItem = cameraItem["dist"];
+            const json& coeffs = (!distItem.empty() && distItem[0].is_array()) ? distItem[0] : distItem;
+            cameraData.dist = coeffs.get<std::vector<double>>();
+
+            size_t coeffsNum = cameraData.dist.size();
+            if (coeffsNum != 4 && coeffsNum != 5 && coeffsNum != 8) {
+                std::cerr << "Ignoring distortion of camera " << cameraData.name << ": expected 4, 5 or 8 coefficients, got "
+                          << coeffsNum << std::endl;
+                cameraData.dist.clear();
+            }
+        }
+
         cameraParametersList.push_back(cameraData);
     }
 
     return cameraParametersList;
 }
 
+// Function to write camera parameters to a JSON file in the schema loadCameraParamsFromJson reads
+bool saveCameraParamsToJson(const std::vector<CameraData>& cameraParams, const std::string& jsonFilePath) {
+    json jsonData = json::array();
+    for (const CameraData& cameraData : cameraParams) {
+        json cameraItem;
+        cameraItem["name"] = cameraData.name;
+        cameraItem["tvec"] = cameraData.tvec;
+        cameraItem["rvec"] = json::array({cameraData.rvec});
+        cameraItem["K"] = cameraData.K;
+        if (!cameraData.dist.empty()) {
+            cameraItem["dist"] = cameraData.dist;
+        }
+        jsonData.push_back(cameraItem);
+    }
+
+    std::ofstream fileStream(jsonFilePath);
+    if (!fileStream) {
+        std::cerr << "Could not write JSON file: " << jsonFilePath << std::endl;
+        return false;
+    }
+    fileStream << jsonData.dump(4) << std::endl;
+    return true;
+}
+
 #endif // CAMERA_PARAMETERS_H
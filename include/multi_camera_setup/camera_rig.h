@@ -0,0 +1,34 @@
+#ifndef CAMERA_RIG_H
+#define CAMERA_RIG_H
+
+#include <vector>
+#include "camera.h"
+#include "camera_parameters.h"
+#include "camera_state.h"
+
+// All cameras of the setup with their state split by access pattern: the cold Camera objects,
+// the hot per camera track states in one cache line aligned array, and the per frame geometry
+// as parallel arrays. Cameras point into states, so a rig is neither copied nor resized.
+class CameraRig {
+public:
+    std::vector<CameraTrackState> states; // Indexed like cameras
+    std::vector<Camera> cameras;
+    CameraGeometryBlock geometry;
+
+    explicit CameraRig(const std::vector<CameraData>& cameraParams)
+    : states(cameraParams.size()) {
+        cameras.reserve(cameraParams.size());
+        int index = 1;
+        for (const auto& param : cameraParams) {
+            cameras.emplace_back(param.name, param.tvec, param.rvec, param.K, param.dist, index, states[index - 1]);
+            index++;
+        }
+    }
+
+    CameraRig(const CameraRig&) = delete;
+    CameraRig& operator=(const CameraRig&) = delete;
+
+    size_t size() const { return cameras.size(); }
+};
+
+#endif // CAMERA_RIG_H
@@ -0,0 +1,84 @@
+#ifndef CAMERA_STATE_H
+#define CAMERA_STATE_H
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "kalman.h"
+#include "dlt.h"
+
+// Per frame tracker a camera runs, from most to least expensive
+enum class TrackerMode {
+    FullDetection, // Detection on the whole frame
+    RoiDetection, // Detection on a window around the predicted position
+    OpticalFlow, // Lucas-Kanade from the previous frame only
+    CorrelationFilter, // MOSSE correlation filter trained on earlier frames
+    PredictOnly // No image work, the Kalman prediction stands in
+};
+
+// Measurements behind a camera's position in one frame
+enum MeasurementFlags : uint8_t {
+    MeasuredByDetection = 1,
+    MeasuredByFlow = 2,
+    MeasuredByCorrelation = 4
+};
+
+// Hot per frame tracking state of one camera. The states of all cameras live in one contiguous
+// array (see CameraRig), each starting on its own cache line, so the TBB worker writing one camera
+// never invalidates the line another worker is writing and the per frame walks over all cameras
+// stay off the cold calibration, video and image data.
+struct alignas(64) CameraTrackState {
+    cv::Point2f current_tracker_position; // Center of the ball
+    cv::Point2f previous_tracker_position; // Previous center of the ball
+    cv::Point2f tracker_speed; // 2D speed of the ball
+    float tracker_radius = 0.0f; // Radius of the last detected ball, 0 when not detected this frame
+    float blob_area = 0.0f; // Contour area of the detected ball, 0 when not detected this frame
+    cv::Point2d undistorted_position; // Current position after lens undistortion, used for triangulation
+    bool is_detection_active = false;
+    bool is_detection_valid = false; // Position is backed by a detection or optical flow this frame
+    bool is_tracking = false; // Kalman filter holds a live track
+    uint8_t measurement_flags = 0; // MeasurementFlags backing this frame's position
+    TrackerMode tracker_mode = TrackerMode::FullDetection; // Tracker selected for this frame
+    int frames_since_detection = 0; // Frames since the last valid detection
+    double tracking_ms = 0.0; // Time spent tracking this frame
+
+    SimpleKalmanFilter kalman_fitler; // Kalman filter ovject
+};
+
+static_assert(sizeof(CameraTrackState) % 64 == 0, "track states must not share cache lines");
+
+// Per frame geometry of all cameras as parallel arrays indexed by camera, the layout
+// triangulation and the world tracker walk once the cameras are done
+struct CameraGeometryBlock {
+    std::vector<cv::Mat> projection_matrices; // For the DLT and the quality metrics
+    std::vector<cv::Matx34d> projections; // Same matrices in fixed size form for the world tracker
+    std::vector<cv::Vec3d> camera_centers; // Camera centers for the triangulation angle
+    std::vector<cv::Point2d> image_points; // Undistorted observations of this frame
+    std::vector<uint8_t> valid; // Observation is backed by a measurement this frame
+    DltKernel dlt_kernel = nullptr; // Triangulation kernel for this camera count
+
+    void setProjectionMatrices(const std::vector<cv::Mat>& matrices) {
+        projection_matrices = matrices;
+        projections.clear();
+        camera_centers.clear();
+        for (const cv::Mat& P : matrices) {
+            projections.push_back(cv::Matx34d(P));
+            camera_centers.push_back(cameraCenter(projections.back()));
+        }
+        image_points.assign(matrices.size(), cv::Point2d());
+        valid.assign(matrices.size(), 0);
+        dlt_kernel = selectDltKernel(matrices.size());
+    }
+
+    size_t size() const { return image_points.size(); }
+
+    // Method to copy this frame's observations out of the track states
+    void gather(const std::vector<CameraTrackState>& states) {
+        for (size_t i = 0; i < states.size(); ++i) {
+            image_points[i] = states[i].undistorted_position;
+            valid[i] = states[i].is_detection_valid ? 1 : 0;
+        }
+    }
+};
+
+#endif // CAMERA_STATE_H
@@ -0,0 +1,193 @@
+#ifndef CORRELATION_TRACKER_H
+#define CORRELATION_TRACKER_H
+
+#include <algorithm>
+#include <cmath>
+#include <opencv2/opencv.hpp>
+
+// Tuning of the MOSSE correlation filter tracker
+struct CorrelationTrackerConfig {
+    int patch_size = 64; // Requested patch side, rounded up to a fast DFT size
+    float learning_rate = 0.125f; // Weight of the newest frame in the running filter
+    float target_sigma = 2.0f; // Width of the desired Gaussian correlation peak (pixels)
+    float regularization = 1e-3f; // Added to the filter denominator
+    float min_psr = 7.0f; // Peak to sidelobe ratio below which the track is considered lost
+};
+
+// MOSSE (Bolme et al.) correlation filter on a grayscale patch around the ball.
+// All buffers are sized once in init() and reused, so a frame costs two small forward DFTs,
+// one inverse DFT and a few element-wise passes.
+class CorrelationTracker {
+public:
+    explicit CorrelationTracker(const CorrelationTrackerConfig& config = CorrelationTrackerConfig())
+    : config(config) {}
+
+    bool isInitialized() const { return initialized; }
+    float peakToSidelobe() const { return psr; }
+
+    // Method to (re)start the filter on the patch around center
+    void init(const cv::Mat& frame, const cv::Point2f& center) {
+        allocate();
+        extractSpectrum(frame, center, patch_spectrum);
+        numerator.setTo(cv::Scalar::all(0));
+        denominator.setTo(cv::Scalar::all(0));
+        accumulate(1.0f);
+        initialized = true;
+    }
+
+    // Method to locate the ball near expected_center, then train on the new location
+    bool update(const cv::Mat& frame, const cv::Point2f& expected_center, cv::Point2f& tracked_center) {
+        if (!initialized) {
+            return false;
+        }
+
+        // Correlate the new patch with the filter H* = A / B
+        extractSpectrum(frame, expected_center, patch_spectrum);
+        for (int y = 0; y < size.height; ++y) {
+            const cv::Vec2f* F = patch_spectrum.ptr<cv::Vec2f>(y);
+            const cv::Vec2f* A = numerator.ptr<cv::Vec2f>(y);
+            const float* B = denominator.ptr<float>(y);
+            cv::Vec2f* R = response_spectrum.ptr<cv::Vec2f>(y);
+            for (int x = 0; x < size.width; ++x) {
+                float inv = 1.0f / (B[x] + config.regularization);
+                float h_re = A[x][0] * inv;
+                float h_im = A[x][1] * inv;
+                R[x] = cv::Vec2f(F[x][0] * h_re - F[x][1] * h_im, F[x][0] * h_im + F[x][1] * h_re);
+            }
+        }
+        cv::idft(response_spectrum, response, cv::DFT_SCALE | cv::DFT_REAL_OUTPUT);
+
+        cv::Point peak;
+        double peak_value;
+        cv::minMaxLoc(response, nullptr, &peak_value, nullptr, &peak);
+        psr = peakToSidelobeRatio(peak, static_cast<float>(peak_value));
+
+        // The response is circular, peaks past the middle are negative shifts
+        int dx = peak.x > size.width / 2 ? peak.x - size.width : peak.x;
+        int dy = peak.y > size.height / 2 ? peak.y - size.height : peak.y;
+        tracked_center = expected_center + cv::Point2f(static_cast<float>(dx), static_cast<float>(dy));
+
+        if (psr < config.min_psr) {
+            return false;
+        }
+
+        // Online update on the patch centered on the new location
+        extractSpectrum(frame, tracked_center, patch_spectrum);
+        accumulate(config.learning_rate);
+        return true;
+    }
+
+    // Method to train on a known location, e.g. a detection, without searching
+    void train(const cv::Mat& frame, const cv::Point2f& center) {
+        if (!initialized) {
+            init(frame, center);
+            return;
+        }
+        extractSpectrum(frame, center, patch_spectrum);
+        accumulate(config.learning_rate);
+    }
+
+private:
+    void allocate() {
+        int side = cv::getOptimalDFTSize(config.patch_size);
+        if (size == cv::Size(side, side)) {
+            return;
+        }
+        size = cv::Size(side, side);
+
+        cv::createHanningWindow(window, size, CV_32F);
+
+        // Desired response: a Gaussian peak at the origin of the circular correlation
+        cv::Mat target(size, CV_32F);
+        float scale = -0.5f / (config.target_sigma * config.target_sigma);
+        for (int y = 0; y < side; ++y) {
+            int wy = std::min(y, side - y);
+            for (int x = 0; x < side; ++x) {
+                int wx = std::min(x, side - x);
+                target.at<float>(y, x) = std::exp(scale * (wx * wx + wy * wy));
+            }
+        }
+        cv::dft(target, target_spectrum, cv::DFT_COMPLEX_OUTPUT);
+
+        numerator.create(size, CV_32FC2);
+        denominator.create(size, CV_32F);
+        patch_spectrum.create(size, CV_32FC2);
+        response_spectrum.create(size, CV_32FC2);
+        response.create(size, CV_32F);
+    }
+
+    // Method to crop, normalize and window the patch around center and take its DFT
+    void extractSpectrum(const cv::Mat& frame, const cv::Point2f& center, cv::Mat& spectrum) {
+        cv::getRectSubPix(frame, size, center, patch_color);
+        if (patch_color.channels() == 3) {
+            cv::cvtColor(patch_color, patch_gray, cv::COLOR_BGR2GRAY);
+        } else {
+            patch_color.copyTo(patch_gray);
+        }
+        patch_gray.convertTo(patch, CV_32F, 1.0, 1.0);
+        cv::log(patch, patch);
+
+        cv::Scalar mean, stddev;
+        cv::meanStdDev(patch, mean, stddev);
+        patch.convertTo(patch, CV_32F, 1.0 / (stddev[0] + 1e-5), -mean[0] / (stddev[0] + 1e-5));
+        cv::multiply(patch, window, patch);
+
+        cv::dft(patch, spectrum, cv::DFT_COMPLEX_OUTPUT);
+    }
+
+    // Method to blend the current patch spectrum into A = G F* and B = F F*
+    void accumulate(float rate) {
+        for (int y = 0; y < size.height; ++y) {
+            const cv::Vec2f* F = patch_spectrum.ptr<cv::Vec2f>(y);
+            const cv::Vec2f* G = target_spectrum.ptr<cv::Vec2f>(y);
+            cv::Vec2f* A = numerator.ptr<cv::Vec2f>(y);
+            float* B = denominator.ptr<float>(y);
+            for (int x = 0; x < size.width; ++x) {
+                float a_re = G[x][0] * F[x][0] + G[x][1] * F[x][1];
+                float a_im = G[x][1] * F[x][0] - G[x][0] * F[x][1];
+                float b = F[x][0] * F[x][0] + F[x][1] * F[x][1];
+                A[x] = cv::Vec2f((1.0f - rate) * A[x][0] + rate * a_re, (1.0f - rate) * A[x][1] + rate * a_im);
+                B[x] = (1.0f - rate) * B[x] + rate * b;
+            }
+        }
+    }
+
+    // Method to compute (peak - mean) / stddev of the response outside an 11x11 window around the peak
+    float peakToSidelobeRatio(const cv::Point& peak, float peak_value) const {
+        double sum = 0.0, squared_sum = 0.0;
+        int count = 0;
+        for (int y = 0; y < size.height; ++y) {
+            const float* row = response.ptr<float>(y);
+            int wy = std::abs(y - peak.y);
+            wy = std::min(wy, size.height - wy);
+            for (int x = 0; x < size.width; ++x) {
+                int wx = std::abs(x - peak.x);
+                wx = std::min(wx, size.width - wx);
+                if (wx <= 5 && wy <= 5) {
+                    continue;
+                }
+                sum += row[x];
+                squared_sum += row[x] * row[x];
+                count++;
+            }
+        }
+        if (count == 0) {
+            return 0.0f;
+        }
+        double mean = sum / count;
+        double stddev = std::sqrt(std::max(squared_sum / count - mean * mean, 1e-12));
+        return static_cast<float>((peak_value - mean) / stddev);
+    }
+
+    CorrelationTrackerConfig config;
+    cv::Size size;
+    cv::Mat window; // Hanning window
+    cv::Mat target_spectrum; // G
+    cv::Mat numerator; // A
+    cv::Mat denominator; // B
+    cv::Mat patch_color, patch_gray, patch, patch_spectrum, response_spectrum, response;
+    float psr = 0.0f;
+    bool initialized = false;
+};
+
+#endif // CORRELATION_TRACKER_H
@@ -0,0 +1,100 @@
+#ifndef DETECTION_PARAMS_H
+#define DETECTION_PARAMS_H
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <opencv2/opencv.hpp>
+#include <nlohmann/json.hpp>
+
+// Thresholds of the color and background subtraction ball detector
+struct DetectionParams {
+    cv::Scalar hsv_lower = cv::Scalar(130, 50, 50); // Pink ball in OpenCV HSV (H in 0-180)
+    cv::Scalar hsv_upper = cv::Scalar(180, 255, 255);
+    double background_threshold = 50.0; // Gray level difference from the background that counts as foreground
+    int morphology_iterations = 2; // Dilate then erode iterations cleaning the mask
+    float area_threshold = 50.0f; // Smallest contour area accepted as the ball (pixels)
+    int flow_roi_size = 128; // Side of the optical flow crop around the ball
+    int tile_rows = 128; // Rows per parallel tile of the mask stages, 0 disables tiling. Does not change the mask
+};
+
+// Search of the detection tuner
+struct DetectionTunerConfig {
+    int frames = 120; // Decoded frames per camera held in memory for all evaluations
+    int samples = 0; // Random configurations to evaluate, 0 evaluates the grid
+    unsigned int seed = 7; // Seed of the random search
+    double max_missing = 0.05; // Fraction of frames without a position above which a configuration is not on the front
+    std::string output; // CSV of every evaluated configuration
+    std::string front_output; // JSON of the Pareto front, each entry loadable with --detection
+};
+
+// Function to convert detection parameters to JSON
+inline nlohmann::json detectionParamsToJson(const DetectionParams& params) {
+    return nlohmann::json{{"hsv_lower", {params.hsv_lower[0], params.hsv_lower[1], params.hsv_lower[2]}},
+                          {"hsv_upper", {params.hsv_upper[0], params.hsv_upper[1], params.hsv_upper[2]}},
+                          {"background_threshold", params.background_threshold},
+                          {"morphology_iterations", params.morphology_iterations},
+                          {"area_threshold", params.area_threshold},
+                          {"flow_roi_size", params.flow_roi_size}};
+}
+
+// Function to read detection parameters from JSON, missing keys keep the values of params
+inline DetectionParams detectionParamsFromJson(const nlohmann::json& data, DetectionParams params = DetectionParams()) {
+    auto readScalar = [&](const char* key, cv::Scalar& value) {
+        if (data.contains(key) && data[key].size() == 3) {
+            value = cv::Scalar(data[key][0].get<double>(), data[key][1].get<double>(), data[key][2].get<double>());
+        }
+    };
+    readScalar("hsv_lower", params.hsv_lower);
+    readScalar("hsv_upper", params.hsv_upper);
+    params.background_threshold = data.value("background_threshold", params.background_threshold);
+    params.morphology_iterations = data.value("morphology_iterations", params.morphology_iterations);
+    params.area_threshold = data.value("area_threshold", params.area_threshold);
+    params.flow_roi_size = data.value("flow_roi_size", params.flow_roi_size);
+    params.tile_rows = data.value("tile_rows", params.tile_rows);
+    return params;
+}
+
+// Function to load detection parameters from a JSON file: one parameter object, or an array of entries
+// like the tuner's Pareto front, one of which is picked with an index suffix (front.json:2)
+inline bool loadDetectionParams(const std::string& argument, DetectionParams& params) {
+    std::string path = argument;
+    int index = -1;
+    size_t separator = argument.rfind(':');
+    if (separator != std::string::npos && separator + 1 < argument.size() &&
+        argument.find_first_not_of("0123456789", separator + 1) == std::string::npos) {
+        path = argument.substr(0, separator);
+        index = std::stoi(argument.substr(separator + 1));
+    }
+
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Could not open detection parameters: " << path << std::endl;
+        return false;
+    }
+    try {
+        nlohmann::json data = nlohmann::json::parse(file);
+        if (data.is_array()) {
+            if (index < 0 || index >= static_cast<int>(data.size())) {
+                std::cerr << "Detection parameters " << path << " hold " << data.size()
+                          << " entries, pick one with " << path << ":<index>" << std::endl;
+                return false;
+            }
+            data = data[index];
+        } else if (index >= 0) {
+            std::cerr << "Detection parameters " << path << " are a single entry, drop the index" << std::endl;
+            return false;
+        }
+        if (!data.is_object()) {
+            std::cerr << "Invalid detection parameters " << argument << ": not an object" << std::endl;
+            return false;
+        }
+        params = detectionParamsFromJson(data.contains("params") ? data["params"] : data, params);
+    } catch (const nlohmann::json::exception& error) {
+        std::cerr << "Invalid detection parameters " << argument << ": " << error.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#endif // DETECTION_PARAMS_H
@@ -0,0 +1,160 @@
+#ifndef DLT_H
+#define DLT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Function to compute the center C = -M^-1 * p4 of a camera with P = [M | p4]
+inline cv::Vec3d cameraCenter(const cv::Matx34d& P) {
+    cv::Matx33d M = P.get_minor<3, 3>(0, 0);
+    cv::Vec3d p4(P(0, 3), P(1, 3), P(2, 3));
+    return -(M.inv() * p4);
+}
+
+// Function to fill the two DLT rows of one observation: x * P3 - P1 and y * P3 - P2
+inline void fillDltRows(const cv::Matx34d& P, const cv::Point2d& point, double* row_x, double* row_y) {
+    for (int c = 0; c < 4; ++c) {
+        row_x[c] = point.x * P(2, c) - P(0, c);
+        row_y[c] = point.y * P(2, c) - P(1, c);
+    }
+}
+
+// Function to get the right singular vectors and singular values of a 4x4 matrix (overwritten) by
+// one-sided Jacobi: column pairs are rotated until all four columns are orthogonal, their norms are
+// then the singular values and the accumulated rotations the right singular vectors
+inline void jacobiSvd4(double R[4][4], double V[4][4], double sigma[4]) {
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            V[i][j] = i == j ? 1.0 : 0.0;
+        }
+    }
+    for (int sweep = 0; sweep < 30; ++sweep) {
+        bool rotated = false;
+        for (int p = 0; p < 3; ++p) {
+            for (int q = p + 1; q < 4; ++q) {
+                double alpha = 0.0, beta = 0.0, gamma = 0.0;
+                for (int i = 0; i < 4; ++i) {
+                    alpha += R[i][p] * R[i][p];
+                    beta += R[i][q] * R[i][q];
+                    gamma += R[i][p] * R[i][q];
+                }
+                if (gamma * gamma <= 1e-30 * alpha * beta) {
+                    continue; // Already orthogonal
+                }
+                rotated = true;
+                double zeta = (beta - alpha) / (2.0 * gamma);
+                double t = (zeta >= 0.0 ? 1.0 : -1.0) / (std::abs(zeta) + std::sqrt(1.0 + zeta * zeta));
+                double c = 1.0 / std::sqrt(1.0 + t * t);
+                double s = c * t;
+                for (int i = 0; i < 4; ++i) {
+                    double r_p = R[i][p], r_q = R[i][q];
+                    R[i][p] = c * r_p - s * r_q;
+                    R[i][q] = s * r_p + c * r_q;
+                    double v_p = V[i][p], v_q = V[i][q];
+                    V[i][p] = c * v_p - s * v_q;
+                    V[i][q] = s * v_p + c * v_q;
+                }
+            }
+        }
+        if (!rotated) {
+            break;
+        }
+    }
+    for (int j = 0; j < 4; ++j) {
+        sigma[j] = std::sqrt(R[0][j] * R[0][j] + R[1][j] * R[1][j] + R[2][j] * R[2][j] + R[3][j] * R[3][j]);
+    }
+}
+
+// Function to solve the rows x 4 DLT system A (overwritten). Householder QR first folds the 2N rows into
+// the 4x4 triangle R, which has the singular values and right singular vectors of A, then Jacobi runs on
+// R alone. Unlike the normal equations A^T A this keeps the conditioning unsquared, and it gives the point
+// cv::SVD gives. Rows > 0 fixes the row count at compile time so the row loops unroll, Rows == 0 takes
+// it from rows.
+template <size_t Rows>
+cv::Point3d solveDlt(double (*A)[4], size_t rows, cv::Vec4d& singular_values) {
+    const size_t m = Rows > 0 ? Rows : rows;
+    double R[4][4] = {};
+    for (int k = 0; k < 4 && static_cast<size_t>(k) < m; ++k) {
+        double norm = 0.0;
+        for (size_t i = k; i < m; ++i) {
+            norm += A[i][k] * A[i][k];
+        }
+        norm = std::sqrt(norm);
+        if (norm > 0.0) {
+            // Reflect column k onto -sign(a_kk) * norm * e_k, v = a + sign(a_kk) * norm * e_k is kept in place
+            double diagonal = A[k][k] >= 0.0 ? -norm : norm;
+            A[k][k] -= diagonal;
+            double v_norm = -diagonal * A[k][k]; // v^T v / 2
+            for (int j = k + 1; j < 4; ++j) {
+                double dot = 0.0;
+                for (size_t i = k; i < m; ++i) {
+                    dot += A[i][k] * A[i][j];
+                }
+                double f = dot / v_norm;
+                for (size_t i = k; i < m; ++i) {
+                    A[i][j] -= f * A[i][k];
+                }
+            }
+            R[k][k] = diagonal;
+        }
+        for (int j = k + 1; j < 4; ++j) {
+            R[k][j] = A[k][j];
+        }
+    }
+
+    double V[4][4], sigma[4];
+    jacobiSvd4(R, V, sigma);
+
+    // Singular values in descending order like cv::SVD, the point is the vector of the smallest
+    int order[4] = {0, 1, 2, 3};
+    std::sort(order, order + 4, [&](int a, int b) { return sigma[a] > sigma[b]; });
+    for (int j = 0; j < 4; ++j) {
+        singular_values[j] = sigma[order[j]];
+    }
+    int null = order[3];
+    return cv::Point3d(V[0][null] / V[3][null], V[1][null] / V[3][null], V[2][null] / V[3][null]);
+}
+
+// Kernel triangulating one point from N cameras, the system sits on the stack
+template <size_t N>
+cv::Point3d triangulateDltFixed(const cv::Matx34d* projections, const cv::Point2d* points, size_t,
+                                cv::Vec4d& singular_values) {
+    double A[2 * N][4];
+    for (size_t i = 0; i < N; ++i) {
+        fillDltRows(projections[i], points[i], A[2 * i], A[2 * i + 1]);
+    }
+    return solveDlt<2 * N>(A, 2 * N, singular_values);
+}
+
+// Kernel for any camera count
+inline cv::Point3d triangulateDltDynamic(const cv::Matx34d* projections, const cv::Point2d* points,
+                                         size_t cameras_num, cv::Vec4d& singular_values) {
+    std::vector<double> storage(8 * cameras_num);
+    double (*A)[4] = reinterpret_cast<double (*)[4]>(storage.data());
+    for (size_t i = 0; i < cameras_num; ++i) {
+        fillDltRows(projections[i], points[i], A[2 * i], A[2 * i + 1]);
+    }
+    return solveDlt<0>(A, 2 * cameras_num, singular_values);
+}
+
+using DltKernel = cv::Point3d (*)(const cv::Matx34d*, const cv::Point2d*, size_t, cv::Vec4d&);
+
+// Function to pick the DLT kernel for a camera count: a fixed size one for the rig sizes we deploy,
+// the dynamic one for any other count
+inline DltKernel selectDltKernel(size_t cameras_num) {
+    switch (cameras_num) {
+    case 2: return triangulateDltFixed<2>;
+    case 3: return triangulateDltFixed<3>;
+    case 4: return triangulateDltFixed<4>;
+    case 6: return triangulateDltFixed<6>;
+    case 8: return triangulateDltFixed<8>;
+    case 12: return triangulateDltFixed<12>;
+    case 16: return triangulateDltFixed<16>;
+    default: return triangulateDltDynamic;
+    }
+}
+
+#endif // DLT_H
@@ -0,0 +1,235 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Accuracy thresholds and reporting of a trajectory evaluation, errors are in millimeters
+struct EvaluationConfig {
+    int segment_frames = 30; // Frames per segment of the per segment report
+    double max_rmse_mm = 0.0; // Fail above this RMSE, 0 disables the check
+    double max_p95_mm = 0.0; // Fail above this 95th percentile, 0 disables the check
+    std::string errors_output; // Optional "frame,l2_mm" CSV of the per frame errors
+};
+
+// Error statistics over a run of frames
+struct TrajectoryErrorSummary {
+    size_t samples = 0; // Frames with an estimate
+    size_t missing = 0; // Frames whose estimate is not finite
+    double mean_mm = 0.0;
+    double rmse_mm = 0.0;
+    double median_mm = 0.0;
+    double p90_mm = 0.0;
+    double p95_mm = 0.0;
+    double p99_mm = 0.0;
+    double max_mm = 0.0;
+};
+
+// Function to summarize the per frame L2 errors in [begin, end), NaN marks a missing estimate
+inline TrajectoryErrorSummary summarizeErrors(std::vector<double>::const_iterator begin,
+                                              std::vector<double>::const_iterator end) {
+    TrajectoryErrorSummary summary;
+    std::vector<double> sorted;
+    sorted.reserve(static_cast<size_t>(end - begin));
+    double sum = 0.0, squared_sum = 0.0;
+    for (auto it = begin; it != end; ++it) {
+        if (std::isnan(*it)) {
+            summary.missing++;
+            continue;
+        }
+        sorted.push_back(*it);
+        sum += *it;
+        squared_sum += *it * *it;
+    }
+
+    size_t n = sorted.size();
+    summary.samples = n;
+    if (n == 0) {
+        return summary;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double q) { return sorted[static_cast<size_t>(q * (n - 1))]; };
+    summary.mean_mm = sum / n;
+    summary.rmse_mm = std::sqrt(squared_sum / n);
+    summary.median_mm = percentile(0.5);
+    summary.p90_mm = percentile(0.9);
+    summary.p95_mm = percentile(0.95);
+    summary.p99_mm = percentile(0.99);
+    summary.max_mm = sorted[n - 1];
+    return summary;
+}
+
+// Streaming evaluation of a 3D trajectory against ground truth, fed one frame at a time either
+// by the live pipeline or by evaluateTrajectoryFiles. Keeps one double per frame.
+class TrajectoryEvaluator {
+public:
+    explicit TrajectoryEvaluator(const EvaluationConfig& config = EvaluationConfig()) : config(config) {}
+
+    // Method to add the next frame's estimate, a non-finite estimate counts as missing
+    void add(const cv::Point3d& estimate, const cv::Point3d& groundTruth) {
+        bool finite = std::isfinite(estimate.x) && std::isfinite(estimate.y) && std::isfinite(estimate.z);
+        errors.push_back(finite ? cv::norm(estimate - groundTruth) * 1000.0 : std::numeric_limits<double>::quiet_NaN());
+    }
+
+    size_t frames() const { return errors.size(); }
+
+    TrajectoryErrorSummary summary() const { return summarizeErrors(errors.begin(), errors.end()); }
+
+    // Method to summarize consecutive segments of segment_frames frames
+    std::vector<TrajectoryErrorSummary> segmentSummaries() const {
+        std::vector<TrajectoryErrorSummary> segments;
+        size_t length = static_cast<size_t>(std::max(config.segment_frames, 1));
+        for (size_t first = 0; first < errors.size(); first += length) {
+            size_t last = std::min(first + length, errors.size());
+            segments.push_back(summarizeErrors(errors.begin() + first, errors.begin() + last));
+        }
+        return segments;
+    }
+
+    // Method to print the overall statistics and the per segment RMSE and max
+    void print(const std::string& label) const {
+        TrajectoryErrorSummary all = summary();
+        if (all.samples == 0) {
+            std::cerr << "No samples to compare for " << label << std::endl;
+            return;
+        }
+        std::ios::fmtflags flags = std::cout.flags();
+        std::streamsize precision = std::cout.precision();
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << label << ": " << all.samples << " frames (" << all.missing << " missing), mean " << all.mean_mm
+                  << " mm, RMSE " << all.rmse_mm << " mm, median " << all.median_mm << " mm, p90 " << all.p90_mm
+                  << " mm, p95 " << all.p95_mm << " mm, p99 " << all.p99_mm << " mm, max " << all.max_mm << " mm"
+                  << std::endl;
+
+        std::vector<TrajectoryErrorSummary> segments = segmentSummaries();
+        if (segments.size() > 1) {
+            std::cout << "  segment    frames      RMSE mm       max mm" << std::endl;
+            for (size_t i = 0; i < segments.size(); ++i) {
+                std::cout << "  " << std::setw(7) << i << std::setw(10)
+                          << std::to_string(i * config.segment_frames) + "+" << std::setw(13) << segments[i].rmse_mm
+                          << std::setw(13) << segments[i].max_mm << std::endl;
+            }
+        }
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+
+    // Method to check the thresholds, prints every violated one
+    bool passes() const {
+        TrajectoryErrorSummary all = summary();
+        bool passed = true;
+        if (all.samples == 0 && (config.max_rmse_mm > 0.0 || config.max_p95_mm > 0.0)) {
+            std::cerr << "Accuracy check failed: no samples" << std::endl;
+            return false;
+        }
+        if (config.max_rmse_mm > 0.0 && all.rmse_mm > config.max_rmse_mm) {
+            std::cerr << "Accuracy check failed: RMSE " << all.rmse_mm << " mm > " << config.max_rmse_mm << " mm"
+                      << std::endl;
+            passed = false;
+        }
+        if (config.max_p95_mm > 0.0 && all.p95_mm > config.max_p95_mm) {
+            std::cerr << "Accuracy check failed: p95 " << all.p95_mm << " mm > " << config.max_p95_mm << " mm"
+                      << std::endl;
+            passed = false;
+        }
+        return passed;
+    }
+
+    // Method to write the per frame errors as "frame,l2_mm", empty for missing frames
+    bool writeErrorsCsv(const std::string& path) const {
+        std::ofstream file(path);
+        if (!file) {
+            std::cerr << "Could not write errors file: " << path << std::endl;
+            return false;
+        }
+        file << "frame,l2_mm\n";
+        for (size_t i = 0; i < errors.size(); ++i) {
+            file << i << ",";
+            if (!std::isnan(errors[i])) {
+                file << errors[i];
+            }
+            file << "\n";
+        }
+        return true;
+    }
+
+    // Method to print the report, write the errors CSV if requested and check the thresholds
+    bool finish(const std::string& label) const {
+        print(label);
+        if (!config.errors_output.empty()) {
+            writeErrorsCsv(config.errors_output);
+        }
+        return passes();
+    }
+
+private:
+    EvaluationConfig config;
+    std::vector<double> errors; // L2 error per frame in mm, NaN when missing
+};
+
+// Function to read the next "x,y,z" point of a trajectory CSV, skipping lines that do not parse (e.g. a
+// header). strtod also reads the "nan" the pipeline writes for frames without a position.
+inline bool readTrajectoryPoint(std::istream& input, cv::Point3d& point) {
+    std::string line;
+    while (std::getline(input, line)) {
+        const char* cursor = line.c_str();
+        double values[3];
+        int parsed = 0;
+        for (; parsed < 3; ++parsed) {
+            char* end = nullptr;
+            values[parsed] = std::strtod(cursor, &end);
+            if (end == cursor) {
+                break;
+            }
+            cursor = end;
+            while (*cursor == ',' || *cursor == ' ') {
+                cursor++;
+            }
+        }
+        if (parsed == 3) {
+            point = cv::Point3d(values[0], values[1], values[2]);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Function to stream two trajectory CSVs in lockstep into an evaluator, stops at the shorter one
+inline bool evaluateTrajectoryFiles(const std::string& estimatePath, const std::string& groundTruthPath,
+                                    TrajectoryEvaluator& evaluator) {
+    std::ifstream estimate(estimatePath), groundTruth(groundTruthPath);
+    if (!estimate || !groundTruth) {
+        std::cerr << "Could not open trajectory file: " << (!estimate ? estimatePath : groundTruthPath) << std::endl;
+        return false;
+    }
+    cv::Point3d estimated, truth;
+    while (readTrajectoryPoint(estimate, estimated) && readTrajectoryPoint(groundTruth, truth)) {
+        evaluator.add(estimated, truth);
+    }
+    return true;
+}
+
+// Function to stream a trajectory CSV against ground truth already in memory
+inline bool evaluateTrajectoryFile(const std::string& estimatePath, const std::vector<cv::Point3d>& groundTruth,
+                                   TrajectoryEvaluator& evaluator) {
+    std::ifstream estimate(estimatePath);
+    if (!estimate) {
+        std::cerr << "Could not open trajectory file: " << estimatePath << std::endl;
+        return false;
+    }
+    cv::Point3d estimated;
+    for (size_t i = 0; i < groundTruth.size() && readTrajectoryPoint(estimate, estimated); ++i) {
+        evaluator.add(estimated, groundTruth[i]);
+    }
+    return true;
+}
+
+#endif // EVALUATOR_H
@@ -0,0 +1,48 @@
+#ifndef FIXED_KALMAN_H
+#define FIXED_KALMAN_H
+
+#include <opencv2/opencv.hpp>
+
+// Linear Kalman filter with compile time dimensions.
+// All matrices are cv::Matx, so predict/correct never touch the heap.
+template <int StateDim, int MeasDim, typename T = float>
+class FixedKalmanFilter {
+public:
+    typedef cv::Matx<T, StateDim, 1> StateVec;
+    typedef cv::Matx<T, StateDim, StateDim> StateMat;
+    typedef cv::Matx<T, MeasDim, 1> MeasVec;
+    typedef cv::Matx<T, MeasDim, MeasDim> MeasMat;
+    typedef cv::Matx<T, MeasDim, StateDim> MeasStateMat;
+
+    StateVec state = StateVec::zeros(); // x
+    StateMat covariance = StateMat::eye(); // P
+    StateMat transition = StateMat::eye(); // F
+    StateMat process_noise = StateMat::eye(); // Q
+    MeasStateMat measurement_matrix = MeasStateMat::zeros(); // H
+    MeasMat measurement_noise = MeasMat::eye(); // R
+
+    // x = F x, P = F P F^T + Q
+    const StateVec& predict() {
+        state = transition * state;
+        covariance = transition * covariance * transition.t() + process_noise;
+        return state;
+    }
+
+    const StateVec& correct(const MeasVec& measurement) {
+        return correct(measurement, measurement_noise);
+    }
+
+    // Correction with a per-call measurement noise, for sources of different accuracy
+    const StateVec& correct(const MeasVec& measurement, const MeasMat& noise) {
+        cv::Matx<T, StateDim, MeasDim> PHt = covariance * measurement_matrix.t();
+        MeasMat S = measurement_matrix * PHt + noise;
+        cv::Matx<T, StateDim, MeasDim> gain = PHt * S.inv(cv::DECOMP_LU);
+
+        MeasVec innovation = measurement - measurement_matrix * state;
+        state = state + gain * innovation;
+        covariance = covariance - gain * measurement_matrix * covariance;
+        return state;
+    }
+};
+
+#endif // FIXED_KALMAN_H
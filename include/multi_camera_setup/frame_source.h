@@ -0,0 +1,17 @@
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include <opencv2/opencv.hpp>
+
+// Source of camera frames other than a video file, e.g. a synthetic scene rendered in memory
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    // Method to produce the next frame, returns false at the end of the stream
+    virtual bool read(cv::Mat& frame) = 0;
+    virtual int frameCount() const = 0;
+    virtual double frameRate() const = 0;
+};
+
+#endif // FRAME_SOURCE_H
@@ -3,7 +3,9 @@
 
 #include <opencv2/opencv.hpp>
 #include <iostream>
+#include "fixed_kalman.h"
 
+// Constant velocity 2D tracker, state (x, y, vx, vy) and measurement (x, y)
 class SimpleKalmanFilter {
 public:
     SimpleKalmanFilter() {
@@ -11,54 +13,61 @@ public:
     }
 
     void initKalmanFilter() {
-        // Create Kalman Filter with 4 dynamic parameters and 2 measurement parameters
-        KF.init(4, 2, 0, CV_32F);
-
         // Transition matrix (A)
-        KF.transitionMatrix = (cv::Mat_<float>(4, 4) << 1, 0, 1, 0,
-                                                        0, 1, 0, 1,
-                                                        0, 0, 1, 0,
-                                                        0, 0, 0, 1);
+        KF.transition = cv::Matx44f(1, 0, 1, 0,
+                                    0, 1, 0, 1,
+                                    0, 0, 1, 0,
+                                    0, 0, 0, 1);
 
         // Measurement matrix (H)
-        KF.measurementMatrix = (cv::Mat_<float>(2, 4) << 1, 0, 0, 0,
-                                                         0, 1, 0, 0);
+        KF.measurement_matrix = cv::Matx<float, 2, 4>(1, 0, 0, 0,
+                                                      0, 1, 0, 0);
 
         // Adjust the process noise covariance (Q) to be more responsive
-        cv::setIdentity(KF.processNoiseCov, cv::Scalar::all(1e-2));
+        KF.process_noise = cv::Matx44f::eye() * 1e-2f;
 
         // Adjust the measurement noise covariance (R) to be more responsive
-        cv::setIdentity(KF.measurementNoiseCov, cv::Scalar::all(1e-2));
+        KF.measurement_noise = cv::Matx22f::eye() * 1e-2f;
 
         // Error covariance (P)
-        cv::setIdentity(KF.errorCovPost, cv::Scalar::all(1));
+        KF.covariance = cv::Matx44f::eye();
 
         // Initialize state
-        KF.statePost = cv::Mat::zeros(4, 1, CV_32F);
-        measurement = cv::Mat::zeros(2, 1, CV_32F);
+        KF.state = cv::Matx41f::zeros();
+    }
+
+    // Method to restart tracking at a known position with zero velocity
+    void reset(cv::Point2f position) {
+        initKalmanFilter();
+        KF.state = cv::Matx41f(position.x, position.y, 0, 0);
     }
 
     cv::Point2f predict() {
-        cv::Mat prediction = KF.predict();
-        return cv::Point2f(prediction.at<float>(0), prediction.at<float>(1));
+        const cv::Matx41f& prediction = KF.predict();
+        return cv::Point2f(prediction(0), prediction(1));
     }
 
     void correct(cv::Point2f newPosition, bool isMeasurementValid = true) {
+        // Without a valid measurement the predicted state is already the best estimate
         if (isMeasurementValid) {
-            measurement.at<float>(0) = newPosition.x;
-            measurement.at<float>(1) = newPosition.y;
-        } else {
-            // Use prediction as measurement if the actual measurement is not valid
-            cv::Mat prediction = KF.predict();
-            measurement.at<float>(0) = prediction.at<float>(0);
-            measurement.at<float>(1) = prediction.at<float>(1);
+            KF.correct(cv::Matx21f(newPosition.x, newPosition.y));
         }
-        KF.correct(measurement);
+    }
+
+    // Method to get the position uncertainty, the trace of the position block of P (pixels^2)
+    float positionVariance() const {
+        return KF.covariance(0, 0) + KF.covariance(1, 1);
+    }
+
+    // Method to fuse a measurement with its own noise variance, returns the corrected position
+    cv::Point2f correct(cv::Point2f newPosition, float noiseVariance) {
+        const cv::Matx41f& state = KF.correct(cv::Matx21f(newPosition.x, newPosition.y),
+                                              cv::Matx22f::eye() * noiseVariance);
+        return cv::Point2f(state(0), state(1));
     }
 
 private:
-    cv::KalmanFilter KF;
-    cv::Mat measurement;
+    FixedKalmanFilter<4, 2> KF;
 };
 
 #endif // SIMPLEKALMANFILTER_H
@@ -0,0 +1,128 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory mapping of a whole file, unmapped on destruction
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            bytes = other.bytes;
+            length = other.length;
+#if defined(_WIN32)
+            mapping = other.mapping;
+            other.mapping = nullptr;
+#endif
+            other.bytes = nullptr;
+            other.length = 0;
+        }
+        return *this;
+    }
+    ~MappedFile() { close(); }
+
+    // Method to map the file, returns false (and reports why) if it cannot be opened or is empty
+    bool open(const std::string& path) {
+        close();
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            std::cerr << "Could not open file: " << path << std::endl;
+            return false;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            std::cerr << "Could not map empty file: " << path << std::endl;
+            return false;
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file); // The mapping keeps the file open
+        if (mapping == nullptr) {
+            std::cerr << "Could not map file: " << path << std::endl;
+            return false;
+        }
+        bytes = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (bytes == nullptr) {
+            CloseHandle(mapping);
+            mapping = nullptr;
+            std::cerr << "Could not map file: " << path << std::endl;
+            return false;
+        }
+        length = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Could not open file: " << path << std::endl;
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            std::cerr << "Could not map empty file: " << path << std::endl;
+            return false;
+        }
+        void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping keeps the file open
+        if (address == MAP_FAILED) {
+            std::cerr << "Could not map file: " << path << std::endl;
+            return false;
+        }
+        bytes = static_cast<const unsigned char*>(address);
+        length = static_cast<size_t>(info.st_size);
+#endif
+        return true;
+    }
+
+    void close() {
+        if (bytes == nullptr) {
+            return;
+        }
+#if defined(_WIN32)
+        UnmapViewOfFile(bytes);
+        CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        munmap(const_cast<unsigned char*>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    bool isOpen() const { return bytes != nullptr; }
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+#if defined(_WIN32)
+    HANDLE mapping = nullptr;
+#endif
+};
+
+#endif // MAPPED_FILE_H
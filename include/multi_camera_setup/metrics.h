@@ -0,0 +1,518 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+// Per stage latency histograms and pipeline counters. Recording is compiled in only with
+// MCS_ENABLE_METRICS (CMake option of the same name), the stage scopes also feed the tracer of
+// trace.h with MCS_ENABLE_TRACING. Without either the macros expand to nothing and none of this
+// header's types are touched on the hot path.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "trace.h"
+
+#if !defined(_WIN32)
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Instrumented pipeline stages
+enum class Stage {
+    Decode, // Reading the next frame
+    Detection, // trackerByDetection as a whole
+    Mask, // Color keying, background subtraction and morphology
+    Contours, // Contour search and position extraction
+    Tracking, // Optical flow or correlation filter
+    Triangulation, // DLT or world tracker fusion
+    Output, // CSV output
+    Display, // Visualization windows
+    Camera, // A camera's whole task in the frame's parallel_for
+    Frame, // A whole iteration of the frame loop
+    Count
+};
+
+inline const char* stageName(Stage stage) {
+    static const char* names[] = {"decode", "detection", "mask", "contours", "tracking", "triangulation", "output", "display", "camera", "frame"};
+    return names[static_cast<int>(stage)];
+}
+
+// Log-linear latency histogram in the spirit of HdrHistogram: values below 16 ns are exact, above
+// that every power of two is split into 16 buckets, so quantiles are within 1/16 of the true value
+// up to about 18 minutes. Written by one thread, read concurrently by the reporter, so counts are
+// atomics updated with relaxed load/store pairs instead of read-modify-write instructions.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKETS = 16;
+    static constexpr int MAX_EXPONENT = 40;
+    static constexpr int BUCKETS = SUB_BUCKETS + (MAX_EXPONENT - 4) * SUB_BUCKETS;
+
+    static int bucketIndex(uint64_t ns) {
+        if (ns < SUB_BUCKETS) {
+            return static_cast<int>(ns);
+        }
+#if defined(__GNUC__) || defined(__clang__)
+        int exponent = 63 - __builtin_clzll(ns);
+#else
+        int exponent = 63;
+        while (!(ns >> exponent)) {
+            exponent--;
+        }
+#endif
+        if (exponent >= MAX_EXPONENT) {
+            return BUCKETS - 1;
+        }
+        int shift = exponent - 4;
+        int sub = static_cast<int>(ns >> shift) - SUB_BUCKETS;
+        return SUB_BUCKETS + shift * SUB_BUCKETS + sub;
+    }
+
+    // Lower bound of the values a bucket holds
+    static uint64_t bucketValue(int index) {
+        if (index < SUB_BUCKETS) {
+            return static_cast<uint64_t>(index);
+        }
+        int shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+        int sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+        return static_cast<uint64_t>(SUB_BUCKETS + sub) << shift;
+    }
+
+    // Single writer only
+    void record(uint64_t ns) {
+        bump(counts[bucketIndex(ns)], 1);
+        bump(total_count, 1);
+        bump(total_ns, ns);
+        if (ns > max_ns.load(std::memory_order_relaxed)) {
+            max_ns.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t count() const { return total_count.load(std::memory_order_relaxed); }
+
+private:
+    friend class HistogramSnapshot;
+
+    static void bump(std::atomic<uint64_t>& value, uint64_t amount) {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> counts{};
+    std::atomic<uint64_t> total_count{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> max_ns{0};
+};
+
+// Plain copy of one or more merged histograms, for quantiles and export
+class HistogramSnapshot {
+public:
+    void merge(const LatencyHistogram& histogram) {
+        for (int i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+            counts[i] += histogram.counts[i].load(std::memory_order_relaxed);
+        }
+        count += histogram.total_count.load(std::memory_order_relaxed);
+        sum_ns += histogram.total_ns.load(std::memory_order_relaxed);
+        max_ns = std::max(max_ns, histogram.max_ns.load(std::memory_order_relaxed));
+    }
+
+    void merge(const HistogramSnapshot& other) {
+        for (int i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+            counts[i] += other.counts[i];
+        }
+        count += other.count;
+        sum_ns += other.sum_ns;
+        max_ns = std::max(max_ns, other.max_ns);
+    }
+
+    // Value at quantile q (0..1) in nanoseconds
+    uint64_t quantile(double q) const {
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(q * (count - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                // Middle of the bucket, the error is at most half a bucket either way
+                uint64_t lower = LatencyHistogram::bucketValue(i);
+                uint64_t upper = i + 1 < LatencyHistogram::BUCKETS ? LatencyHistogram::bucketValue(i + 1) : lower + 1;
+                return std::min(lower + (upper - lower) / 2, max_ns);
+            }
+        }
+        return max_ns;
+    }
+
+    std::array<uint64_t, LatencyHistogram::BUCKETS> counts{};
+    uint64_t count = 0;
+    uint64_t sum_ns = 0;
+    uint64_t max_ns = 0;
+};
+
+// Histograms of one thread, one per stage and camera slot (slot 0 holds stages that span all cameras).
+// The owning thread creates a slot's histogram on its first sample and publishes it with a release
+// store, the reporter loads it with acquire, so it never sees a histogram under construction.
+class ThreadMetrics {
+public:
+    explicit ThreadMetrics(size_t size) { resize(size); }
+    ~ThreadMetrics() { clear(); }
+
+    ThreadMetrics(const ThreadMetrics&) = delete;
+    ThreadMetrics& operator=(const ThreadMetrics&) = delete;
+
+    // Method to drop all histograms and size the slots, not concurrent with recording or reporting
+    void resize(size_t size) {
+        clear();
+        histograms.reset(new std::atomic<LatencyHistogram*>[size]);
+        for (size_t i = 0; i < size; ++i) {
+            histograms[i].store(nullptr, std::memory_order_relaxed);
+        }
+        histograms_num = size;
+    }
+
+    // Method for the owning thread to get a slot's histogram, created on first use
+    LatencyHistogram& histogram(size_t index) {
+        LatencyHistogram* histogram = histograms[index].load(std::memory_order_relaxed);
+        if (histogram == nullptr) {
+            histogram = new LatencyHistogram();
+            histograms[index].store(histogram, std::memory_order_release);
+        }
+        return *histogram;
+    }
+
+    // Method for any thread to read a slot's histogram, nullptr until the owning thread recorded into it
+    const LatencyHistogram* find(size_t index) const { return histograms[index].load(std::memory_order_acquire); }
+
+private:
+    void clear() {
+        for (size_t i = 0; i < histograms_num; ++i) {
+            delete histograms[i].load(std::memory_order_relaxed);
+        }
+        histograms_num = 0;
+    }
+
+    std::unique_ptr<std::atomic<LatencyHistogram*>[]> histograms;
+    size_t histograms_num = 0;
+};
+
+// Process wide registry of the per thread histograms and the pipeline counters
+class PipelineMetrics {
+public:
+    static PipelineMetrics& instance() {
+        static PipelineMetrics metrics;
+        return metrics;
+    }
+
+    // Method to size the camera slots, call before the first frame
+    void configure(int cameras_num) {
+        std::lock_guard<std::mutex> lock(mutex);
+        slots = cameras_num + 1;
+        for (auto& thread : threads) {
+            thread->resize(static_cast<size_t>(Stage::Count) * slots);
+        }
+        dropped.reset(new std::atomic<uint64_t>[slots]);
+        for (int i = 0; i < slots; ++i) {
+            dropped[i].store(0);
+        }
+        start_time = last_report_time = std::chrono::steady_clock::now();
+    }
+
+    void record(Stage stage, int camera, uint64_t ns) {
+        thread_local ThreadMetrics* local = nullptr;
+        if (local == nullptr) {
+            local = registerThread();
+        }
+        local->histogram(static_cast<size_t>(stage) * slots + camera).record(ns);
+    }
+
+    void frameDone() { frames.fetch_add(1, std::memory_order_relaxed); }
+    void frameDropped(int camera) { dropped[camera].fetch_add(1, std::memory_order_relaxed); }
+
+    // Method to merge the histograms of all threads for one stage and camera slot, camera < 0 merges all slots
+    HistogramSnapshot snapshot(Stage stage, int camera) const {
+        HistogramSnapshot result;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& thread : threads) {
+            for (int slot = 0; slot < slots; ++slot) {
+                if (camera >= 0 && slot != camera) {
+                    continue;
+                }
+                const LatencyHistogram* histogram = thread->find(static_cast<size_t>(stage) * slots + slot);
+                if (histogram) {
+                    result.merge(*histogram);
+                }
+            }
+        }
+        return result;
+    }
+
+    uint64_t framesTotal() const { return frames.load(std::memory_order_relaxed); }
+    uint64_t droppedTotal(int camera) const { return dropped[camera].load(std::memory_order_relaxed); }
+    int camerasNum() const { return slots - 1; }
+
+    // Method to print p50, p99 and max per stage plus fps and dropped frames since the last summary
+    void printSummary() {
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - last_report_time).count();
+        uint64_t total = framesTotal();
+        double fps = seconds > 0.0 ? (total - last_report_frames) / seconds : 0.0;
+        last_report_time = now;
+        last_report_frames = total;
+
+        uint64_t dropped_frames = 0;
+        for (int slot = 0; slot < slots; ++slot) {
+            dropped_frames += droppedTotal(slot);
+        }
+
+        std::ios::fmtflags flags = std::cout.flags();
+        std::streamsize precision = std::cout.precision();
+        std::cout << "Metrics: " << total << " frames, " << std::fixed << std::setprecision(1) << fps << " fps, "
+                  << dropped_frames << " dropped" << std::endl;
+        std::cout << "  " << std::left << std::setw(14) << "stage" << std::right << std::setw(10) << "count"
+                  << std::setw(12) << "p50 ms" << std::setw(12) << "p99 ms" << std::setw(12) << "max ms" << std::endl;
+        for (int s = 0; s < static_cast<int>(Stage::Count); ++s) {
+            HistogramSnapshot all = snapshot(static_cast<Stage>(s), -1);
+            if (all.count == 0) {
+                continue;
+            }
+            std::cout << "  " << std::left << std::setw(14) << stageName(static_cast<Stage>(s)) << std::right
+                      << std::setw(10) << all.count << std::setprecision(3) << std::setw(12) << all.quantile(0.5) * 1e-6
+                      << std::setw(12) << all.quantile(0.99) * 1e-6 << std::setw(12) << all.max_ns * 1e-6 << std::endl;
+        }
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+
+    // Method to render all metrics in the Prometheus text exposition format
+    std::string prometheusText() const {
+        std::ostringstream out;
+        out << std::setprecision(9);
+        out << "# HELP mcs_stage_latency_seconds Latency of a pipeline stage per camera (camera 0 spans all cameras)\n";
+        out << "# TYPE mcs_stage_latency_seconds summary\n";
+        for (int s = 0; s < static_cast<int>(Stage::Count); ++s) {
+            for (int slot = 0; slot < slots; ++slot) {
+                HistogramSnapshot histogram = snapshot(static_cast<Stage>(s), slot);
+                if (histogram.count == 0) {
+                    continue;
+                }
+                std::string labels = "stage=\"" + std::string(stageName(static_cast<Stage>(s))) + "\",camera=\"" +
+                                     std::to_string(slot) + "\"";
+                for (double q : {0.5, 0.9, 0.99, 1.0}) {
+                    out << "mcs_stage_latency_seconds{" << labels << ",quantile=\"" << q << "\"} "
+                        << (q < 1.0 ? histogram.quantile(q) : histogram.max_ns) * 1e-9 << "\n";
+                }
+                out << "mcs_stage_latency_seconds_sum{" << labels << "} " << histogram.sum_ns * 1e-9 << "\n";
+                out << "mcs_stage_latency_seconds_count{" << labels << "} " << histogram.count << "\n";
+            }
+        }
+        out << "# HELP mcs_frames_total Frames processed by the pipeline\n";
+        out << "# TYPE mcs_frames_total counter\n";
+        out << "mcs_frames_total " << framesTotal() << "\n";
+        out << "# HELP mcs_dropped_frames_total Frames a camera could not read\n";
+        out << "# TYPE mcs_dropped_frames_total counter\n";
+        for (int slot = 1; slot < slots; ++slot) {
+            out << "mcs_dropped_frames_total{camera=\"" << slot << "\"} " << droppedTotal(slot) << "\n";
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        out << "# HELP mcs_frames_per_second Average frame rate since start\n";
+        out << "# TYPE mcs_frames_per_second gauge\n";
+        out << "mcs_frames_per_second " << (seconds > 0.0 ? framesTotal() / seconds : 0.0) << "\n";
+        return out.str();
+    }
+
+    // Method to write the Prometheus text atomically (write then rename), e.g. for a textfile collector
+    bool writePrometheusFile(const std::string& path) const {
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary);
+            if (!file) {
+                std::cerr << "Could not write metrics file: " << path << std::endl;
+                return false;
+            }
+            file << prometheusText();
+        }
+        std::remove(path.c_str());
+        return std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+private:
+    PipelineMetrics() { configure(0); }
+
+    ThreadMetrics* registerThread() {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.emplace_back(new ThreadMetrics(static_cast<size_t>(Stage::Count) * slots));
+        return threads.back().get();
+    }
+
+    int slots = 1;
+    mutable std::mutex mutex; // Guards the thread list only, never held while recording
+    std::vector<std::unique_ptr<ThreadMetrics>> threads;
+    std::atomic<uint64_t> frames{0};
+    std::unique_ptr<std::atomic<uint64_t>[]> dropped;
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point last_report_time;
+    uint64_t last_report_frames = 0;
+};
+
+inline const char* traceStageName(int stage) { return stageName(static_cast<Stage>(stage)); }
+
+// Records the lifetime of a scope into the stage histogram of a camera and, while tracing, as a trace event
+class ScopedStageTimer {
+public:
+    ScopedStageTimer(Stage stage, int camera) : stage(stage), camera(camera) {
+#ifndef MCS_ENABLE_METRICS
+        if (!PipelineTracer::instance().isEnabled()) {
+            return;
+        }
+#endif
+        start_ns = PipelineTracer::instance().now();
+    }
+
+    ~ScopedStageTimer() {
+        if (start_ns < 0) {
+            return;
+        }
+        PipelineTracer& tracer = PipelineTracer::instance();
+        int64_t end_ns = tracer.now();
+        (void)end_ns;
+#ifdef MCS_ENABLE_METRICS
+        PipelineMetrics::instance().record(stage, camera, static_cast<uint64_t>(end_ns - start_ns));
+#endif
+#ifdef MCS_ENABLE_TRACING
+        if (tracer.isEnabled()) {
+            tracer.record(static_cast<int>(stage), camera, start_ns, end_ns);
+        }
+#endif
+    }
+
+private:
+    Stage stage;
+    int camera;
+    int64_t start_ns = -1;
+};
+
+#if !defined(_WIN32)
+// Serves the Prometheus text to every client connecting to a Unix domain socket, from a background thread
+class MetricsSocketServer {
+public:
+    ~MetricsSocketServer() { stop(); }
+
+    bool start(const std::string& socket_path) {
+        sockaddr_un address{};
+        if (socket_path.size() >= sizeof(address.sun_path)) {
+            std::cerr << "Metrics socket path too long: " << socket_path << std::endl;
+            return false;
+        }
+        address.sun_family = AF_UNIX;
+        std::snprintf(address.sun_path, sizeof(address.sun_path), "%s", socket_path.c_str());
+
+        // Only a stale socket of an earlier run is replaced, never some other file at that path
+        struct stat existing;
+        if (lstat(socket_path.c_str(), &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                std::cerr << "Metrics socket path exists and is not a socket: " << socket_path << std::endl;
+                return false;
+            }
+            unlink(socket_path.c_str());
+        }
+
+        listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listen_fd, 4) != 0) {
+            std::cerr << "Could not listen on metrics socket: " << socket_path << std::endl;
+            if (listen_fd >= 0) {
+                close(listen_fd);
+                listen_fd = -1;
+            }
+            return false;
+        }
+        path = socket_path;
+        running = true;
+        worker = std::thread([this]() { serve(); });
+        return true;
+    }
+
+    void stop() {
+        if (!running) {
+            return;
+        }
+        running = false;
+        worker.join();
+        close(listen_fd);
+        unlink(path.c_str());
+        listen_fd = -1;
+    }
+
+private:
+    void serve() {
+        while (running) {
+            pollfd request{listen_fd, POLLIN, 0};
+            if (poll(&request, 1, 200) <= 0) {
+                continue; // Timeout, check running again
+            }
+            int client = accept(listen_fd, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+            std::string text = PipelineMetrics::instance().prometheusText();
+            size_t written = 0;
+            while (written < text.size()) {
+                ssize_t n = write(client, text.data() + written, text.size() - written);
+                if (n <= 0) {
+                    break;
+                }
+                written += static_cast<size_t>(n);
+            }
+            close(client);
+        }
+    }
+
+    std::string path;
+    int listen_fd = -1;
+    std::atomic<bool> running{false};
+    std::thread worker;
+};
+#endif
+
+#define MCS_CONCAT_IMPL(a, b) a##b
+#define MCS_CONCAT(a, b) MCS_CONCAT_IMPL(a, b)
+
+#if defined(MCS_ENABLE_METRICS) || defined(MCS_ENABLE_TRACING)
+// Times the rest of the enclosing scope as stage of camera (1-based, 0 for all cameras)
+#define MCS_STAGE_SCOPE(stage, camera) ScopedStageTimer MCS_CONCAT(mcs_stage_timer_, __LINE__)(stage, camera)
+#else
+#define MCS_STAGE_SCOPE(stage, camera) ((void)0)
+#endif
+
+#ifdef MCS_ENABLE_METRICS
+#define MCS_FRAME_DONE() PipelineMetrics::instance().frameDone()
+#define MCS_FRAME_DROPPED(camera) PipelineMetrics::instance().frameDropped(camera)
+#else
+#define MCS_FRAME_DONE() ((void)0)
+#define MCS_FRAME_DROPPED(camera) ((void)0)
+#endif
+
+#ifdef MCS_ENABLE_TRACING
+// Frame index of the trace events recorded from here on
+#define MCS_TRACE_FRAME(frame_index) PipelineTracer::instance().setFrame(frame_index)
+// Frame index of the trace events the calling thread records from here on
+#define MCS_TRACE_THREAD_FRAME(frame_index) PipelineTracer::instance().setThreadFrame(frame_index)
+#else
+#define MCS_TRACE_FRAME(frame_index) ((void)0)
+#define MCS_TRACE_THREAD_FRAME(frame_index) ((void)0)
+#endif
+
+#endif // METRICS_H
@@ -0,0 +1,162 @@
+#ifndef OBSERVATION_LOG_H
+#define OBSERVATION_LOG_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "camera_state.h"
+#include "mapped_file.h"
+
+// Binary log of the per camera 2D observations, written by ObservationLogWriter while tracking and
+// mapped by ObservationLog to replay everything after tracking without decoding any video.
+// Layout in native byte order: ObservationLogHeader, then one ObservationRecord per camera for
+// every frame in (frame, camera) order. The frame count follows from the file size, so a log
+// cut short by a crash replays up to its last complete frame.
+struct ObservationLogHeader {
+    char magic[8]; // "MCSOBSL"
+    uint32_t version;
+    uint32_t byte_order; // 0x01020304 as stored by the writer
+    uint32_t cameras_num;
+    uint32_t record_size;
+    double fps;
+};
+
+// Observation of one camera in one frame
+struct ObservationRecord {
+    double x; // Undistorted image position, the input of triangulation
+    double y;
+    float radius; // Radius of the detected ball, 0 without a detection
+    float area; // Contour area of the detected ball, 0 without a detection
+    uint8_t valid; // Position is backed by a measurement
+    uint8_t measurement_flags; // MeasurementFlags of the measurements behind the position
+    uint8_t tracker_mode; // TrackerMode the camera ran
+    uint8_t reserved[5];
+};
+
+static_assert(std::is_trivially_copyable<ObservationLogHeader>::value && sizeof(ObservationLogHeader) % 8 == 0,
+              "observation log layout");
+static_assert(std::is_trivially_copyable<ObservationRecord>::value && sizeof(ObservationRecord) == 32,
+              "observation log layout");
+
+const char OBSERVATION_LOG_MAGIC[8] = {'M', 'C', 'S', 'O', 'B', 'S', 'L', '\0'};
+const uint32_t OBSERVATION_LOG_VERSION = 1;
+const uint32_t OBSERVATION_LOG_BYTE_ORDER = 0x01020304;
+
+// Appends one frame of observations at a time to a log file
+class ObservationLogWriter {
+public:
+    bool open(const std::string& logPath, size_t cameras_num, double fps) {
+        file.open(logPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Could not write observation log: " << logPath << std::endl;
+            return false;
+        }
+        ObservationLogHeader header{};
+        std::memcpy(header.magic, OBSERVATION_LOG_MAGIC, sizeof(header.magic));
+        header.version = OBSERVATION_LOG_VERSION;
+        header.byte_order = OBSERVATION_LOG_BYTE_ORDER;
+        header.cameras_num = static_cast<uint32_t>(cameras_num);
+        header.record_size = sizeof(ObservationRecord);
+        header.fps = fps;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        records.resize(cameras_num);
+        return static_cast<bool>(file);
+    }
+
+    bool isOpen() const { return file.is_open(); }
+
+    // Method to append the observations of all cameras for one frame
+    void write(const std::vector<CameraTrackState>& states) {
+        for (size_t i = 0; i < records.size(); ++i) {
+            const CameraTrackState& state = states[i];
+            ObservationRecord& record = records[i];
+            record = ObservationRecord{};
+            record.x = state.undistorted_position.x;
+            record.y = state.undistorted_position.y;
+            record.radius = state.tracker_radius;
+            record.area = state.blob_area;
+            record.valid = state.is_detection_valid ? 1 : 0;
+            record.measurement_flags = state.measurement_flags;
+            record.tracker_mode = static_cast<uint8_t>(state.tracker_mode);
+        }
+        file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(ObservationRecord));
+    }
+
+    void close() { file.close(); }
+
+private:
+    std::ofstream file;
+    std::vector<ObservationRecord> records; // One frame, reused
+};
+
+// Memory mapped observation log
+class ObservationLog {
+public:
+    // Method to map and check a log, returns false (and reports why) if it is not usable
+    bool open(const std::string& logPath) {
+        if (!file.open(logPath)) {
+            return false;
+        }
+        auto reject = [&](const std::string& reason) {
+            std::cerr << "Invalid observation log " << logPath << ": " << reason << std::endl;
+            file.close();
+            header = nullptr;
+            return false;
+        };
+
+        if (file.size() < sizeof(ObservationLogHeader)) {
+            return reject("truncated header");
+        }
+        header = reinterpret_cast<const ObservationLogHeader*>(file.data());
+        if (std::memcmp(header->magic, OBSERVATION_LOG_MAGIC, sizeof(header->magic)) != 0) {
+            return reject("bad magic");
+        }
+        if (header->version != OBSERVATION_LOG_VERSION || header->record_size != sizeof(ObservationRecord)) {
+            return reject("unsupported version " + std::to_string(header->version));
+        }
+        if (header->byte_order != OBSERVATION_LOG_BYTE_ORDER) {
+            return reject("written on a machine with a different byte order");
+        }
+        if (header->cameras_num == 0) {
+            return reject("no cameras");
+        }
+        records = reinterpret_cast<const ObservationRecord*>(file.data() + sizeof(ObservationLogHeader));
+        frames_num = (file.size() - sizeof(ObservationLogHeader)) / (header->cameras_num * sizeof(ObservationRecord));
+        return true;
+    }
+
+    bool isOpen() const { return header != nullptr; }
+    size_t camerasNum() const { return header ? header->cameras_num : 0; }
+    size_t framesNum() const { return frames_num; }
+    double fps() const { return header ? header->fps : 0.0; }
+
+    const ObservationRecord& record(size_t frame_index, size_t camera) const {
+        return records[frame_index * camerasNum() + camera];
+    }
+
+    // Method to put a frame's observations back into the track states, as tracking left them
+    void restore(size_t frame_index, std::vector<CameraTrackState>& states) const {
+        const ObservationRecord* frame = records + frame_index * camerasNum();
+        for (size_t i = 0; i < states.size(); ++i) {
+            CameraTrackState& state = states[i];
+            state.undistorted_position = cv::Point2d(frame[i].x, frame[i].y);
+            state.tracker_radius = frame[i].radius;
+            state.blob_area = frame[i].area;
+            state.is_detection_valid = frame[i].valid != 0;
+            state.measurement_flags = frame[i].measurement_flags;
+            state.tracker_mode = static_cast<TrackerMode>(frame[i].tracker_mode);
+        }
+    }
+
+private:
+    MappedFile file;
+    const ObservationLogHeader* header = nullptr;
+    const ObservationRecord* records = nullptr;
+    size_t frames_num = 0;
+};
+
+#endif // OBSERVATION_LOG_H
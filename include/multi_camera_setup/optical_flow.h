@@ -0,0 +1,121 @@
+#ifndef OPTICAL_FLOW_H
+#define OPTICAL_FLOW_H
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Tuning of the per camera Lucas-Kanade tracker
+struct OpticalFlowConfig {
+    int roi_size = 128; // Side of the square grayscale crop the pyramids are built on
+    cv::Size window = cv::Size(21, 21); // LK search window per pyramid level
+    int max_level = 2; // Pyramid levels above the base
+    float max_forward_backward_error = 1.0f; // Pixels, larger round trip errors are rejected as drift
+    cv::TermCriteria criteria = cv::TermCriteria(cv::TermCriteria::EPS | cv::TermCriteria::COUNT, 10, 0.03);
+};
+
+// Single point Lucas-Kanade tracker on a grayscale ROI around the ball.
+// The pyramid built for the current frame is kept and reused as the previous pyramid on the next
+// frame, so each frame costs one small crop, one pyramid and a forward-backward LK pair.
+class OpticalFlowTracker {
+public:
+    explicit OpticalFlowTracker(const OpticalFlowConfig& config = OpticalFlowConfig())
+    : config(config) {}
+
+    bool hasPrevious() const { return has_previous; }
+    float forwardBackwardError() const { return forward_backward_error; }
+    float trackingError() const { return tracking_error; }
+
+    void invalidate() { has_previous = false; }
+
+    // Method to check that a point lies far enough inside the stored ROI to be tracked from it
+    bool covers(const cv::Point2f& point) const {
+        if (!has_previous) {
+            return false;
+        }
+        float margin = static_cast<float>(config.window.width / 2);
+        cv::Point2f local = point - cv::Point2f(previous_roi.tl());
+        return local.x >= margin && local.y >= margin &&
+               local.x < previous_roi.width - margin && local.y < previous_roi.height - margin;
+    }
+
+    // Method to store the pyramid of the ROI around point as the reference for the next frame
+    void prepare(const cv::Mat& frame, const cv::Point2f& point) {
+        previous_roi = buildPyramid(frame, point, previous_pyramid);
+        has_previous = true;
+    }
+
+    // Method to track previous_point into the current frame, searching around expected_point.
+    // The current pyramid becomes the reference for the next call either way.
+    bool track(const cv::Mat& frame, const cv::Point2f& previous_point, const cv::Point2f& expected_point,
+               cv::Point2f& tracked_point) {
+        cv::Rect current_roi = buildPyramid(frame, expected_point, current_pyramid);
+
+        bool valid = false;
+        if (covers(previous_point) && current_roi.size() == previous_roi.size()) {
+            points[0] = previous_point - cv::Point2f(previous_roi.tl());
+            forward[0] = expected_point - cv::Point2f(current_roi.tl());
+
+            cv::calcOpticalFlowPyrLK(previous_pyramid, current_pyramid, points, forward, status, errors,
+                                     config.window, config.max_level, config.criteria, cv::OPTFLOW_USE_INITIAL_FLOW);
+            if (status[0]) {
+                tracking_error = errors[0];
+
+                // Track back to the previous frame, a drifting point does not return to its start
+                backward[0] = points[0];
+                cv::calcOpticalFlowPyrLK(current_pyramid, previous_pyramid, forward, backward, status, errors,
+                                         config.window, config.max_level, config.criteria, cv::OPTFLOW_USE_INITIAL_FLOW);
+                forward_backward_error = status[0] ? static_cast<float>(cv::norm(backward[0] - points[0]))
+                                                   : std::numeric_limits<float>::max();
+                valid = forward_backward_error <= config.max_forward_backward_error &&
+                        cv::Rect(cv::Point(), current_roi.size()).contains(cv::Point(forward[0]));
+            }
+            tracked_point = forward[0] + cv::Point2f(current_roi.tl());
+        }
+
+        std::swap(previous_pyramid, current_pyramid);
+        previous_roi = current_roi;
+        has_previous = true;
+        return valid;
+    }
+
+private:
+    // Method to crop a fixed size ROI centered on point (clamped to the frame) and build its pyramid
+    cv::Rect buildPyramid(const cv::Mat& frame, const cv::Point2f& point, std::vector<cv::Mat>& pyramid) {
+        int width = std::min(config.roi_size, frame.cols);
+        int height = std::min(config.roi_size, frame.rows);
+        int x = std::clamp(cvRound(point.x) - width / 2, 0, frame.cols - width);
+        int y = std::clamp(cvRound(point.y) - height / 2, 0, frame.rows - height);
+        cv::Rect roi(x, y, width, height);
+
+        if (frame.channels() == 1) {
+            frame(roi).copyTo(gray);
+        } else {
+            cv::cvtColor(frame(roi), gray, cv::COLOR_BGR2GRAY);
+        }
+        // Never alias the reused crop buffer, the pyramid outlives it by a frame
+        cv::buildOpticalFlowPyramid(gray, pyramid, config.window, config.max_level, true,
+                                    cv::BORDER_REFLECT_101, cv::BORDER_CONSTANT, false);
+        return roi;
+    }
+
+    OpticalFlowConfig config;
+    std::vector<cv::Mat> previous_pyramid;
+    std::vector<cv::Mat> current_pyramid;
+    cv::Rect previous_roi;
+    cv::Mat gray;
+    bool has_previous = false;
+
+    // Reused LK buffers, single element each
+    std::vector<cv::Point2f> points = std::vector<cv::Point2f>(1);
+    std::vector<cv::Point2f> forward = std::vector<cv::Point2f>(1);
+    std::vector<cv::Point2f> backward = std::vector<cv::Point2f>(1);
+    std::vector<uchar> status;
+    std::vector<float> errors;
+
+    float forward_backward_error = 0.0f;
+    float tracking_error = 0.0f;
+};
+
+#endif // OPTICAL_FLOW_H
@@ -0,0 +1,176 @@
+#ifndef PIPELINE_CONFIG_H
+#define PIPELINE_CONFIG_H
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "world_tracker.h"
+#include "smoother.h"
+#include "scheduler.h"
+#include "synthetic_scene.h"
+#include "evaluator.h"
+#include "detection_params.h"
+#include "quorum_fusion.h"
+
+// Tracker between detections and measurement noise of the per camera Kalman fusion (pixels^2)
+struct TrackingFusionConfig {
+    TrackerMode interframe_mode = TrackerMode::OpticalFlow; // OpticalFlow or CorrelationFilter
+    // Below the filter's 1e-2 process noise, so a track follows its measurements instead of lagging the
+    // constant velocity prediction. Flow fuses as tight as detection, between detections it is all there is.
+    float detection_noise = 1e-3f;
+    float flow_noise = 1e-3f;
+    float correlation_noise = 1e-1f;
+};
+
+// Run time options of the tracking pipeline
+struct PipelineConfig {
+    double fps = 30.0; // Frame rate of the input videos, used to timestamp frames
+    int detection_period = 0; // Frames between two detections of a camera, 0 means one per camera
+    TrackingFusionConfig fusion;
+    DetectionParams detection;
+    bool tune = false; // Offline mode: search detection parameters against the ground truth and exit
+    DetectionTunerConfig tuner;
+    bool use_adaptive_scheduler = false; // Pick trackers per camera under a frame budget instead of round-robin
+    SchedulerConfig scheduler;
+    QuorumConfig quorum; // Fuse each frame once a quorum of cameras reported it, cameras on their own threads
+    bool use_world_tracker = false; // Fuse 2D observations in a 3D EKF instead of a per frame DLT
+    WorldTrackerConfig world_tracker;
+    bool write_smoothed = false; // Also write an RTS smoothed trajectory (world tracker only)
+    TrajectorySmootherConfig smoother;
+    std::string smooth_input; // Offline mode: smooth this trajectory CSV and exit
+    std::string smooth_output;
+    std::string ground_truth; // Optional ground truth CSV to report accuracy against
+    std::string evaluate_input; // Offline mode: evaluate this trajectory CSV against the ground truth and exit
+    EvaluationConfig evaluation;
+    std::string trajectory_output; // Trajectory CSV, defaults to csv_files/ball_pos_real.csv
+    std::string smoothed_trajectory_output; // Smoothed trajectory CSV, csv_files/ball_pos_smoothed.csv
+    std::string quality_output; // Triangulation quality histograms CSV, defaults to csv_files/quality_histograms.csv
+    bool display = true; // Show the camera windows
+    std::string record_output; // Observation log of the per camera 2D observations
+    std::string replay_input; // Observation log replayed instead of tracking the videos
+    std::string cache_dir; // Stage cache directory, empty disables the cache
+    int prefetch_frames = 4; // Frames each camera decodes ahead during startup
+    bool synthetic = false; // Track a synthetic scene rendered in memory instead of the videos
+    std::string synthesize_output; // Offline mode: write a synthetic scene to this directory and exit
+    int synthetic_cameras = 0; // Procedural ring of this many cameras, 0 keeps the calibration rig
+    int synthetic_frames = 0; // Ballistic trajectory of this many frames, 0 replays csv_files/ball_pos_gt.csv
+    SyntheticSceneConfig scene;
+    bool compile_calibration = false; // Offline mode: compile cameras.json into the calibration bundle and exit
+    std::string calibration_bundle; // Bundle path, defaults to calibration/cameras.bundle
+    double metrics_interval = 0.0; // Seconds between metrics summaries, 0 prints one at the end (MCS_ENABLE_METRICS builds)
+    std::string metrics_file; // Prometheus text file rewritten with every summary
+    std::string metrics_socket; // Unix socket serving the Prometheus text
+    std::string trace_output; // Chrome trace JSON written at exit (MCS_ENABLE_TRACING builds)
+    size_t trace_events = 1 << 18; // Trace events kept per thread, the newest win
+};
+
+// Function to parse the command line into a pipeline config, unknown options are reported and ignored
+PipelineConfig parsePipelineArgs(int argc, char** argv) {
+    PipelineConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--world-tracker") {
+            config.use_world_tracker = true;
+        } else if (arg == "--detection-period" && i + 1 < argc) {
+            config.detection_period = std::stoi(argv[++i]);
+        } else if (arg == "--adaptive") {
+            config.use_adaptive_scheduler = true;
+        } else if (arg == "--frame-budget-ms" && i + 1 < argc) {
+            config.use_adaptive_scheduler = true;
+            config.scheduler.frame_budget_ms = std::stod(argv[++i]);
+        } else if (arg == "--correlation-filter") {
+            config.fusion.interframe_mode = TrackerMode::CorrelationFilter;
+        } else if (arg == "--gravity") {
+            config.world_tracker.use_gravity = true;
+        } else if (arg == "--smoothed-output") {
+            config.use_world_tracker = true;
+            config.write_smoothed = true;
+        } else if (arg == "--smooth" && i + 2 < argc) {
+            config.smooth_input = argv[++i];
+            config.smooth_output = argv[++i];
+        } else if (arg == "--prefetch-frames" && i + 1 < argc) {
+            config.prefetch_frames = std::stoi(argv[++i]);
+        } else if (arg == "--synthetic") {
+            config.synthetic = true;
+        } else if (arg == "--synthesize" && i + 1 < argc) {
+            config.synthesize_output = argv[++i];
+        } else if (arg == "--synthetic-cameras" && i + 1 < argc) {
+            config.synthetic_cameras = std::stoi(argv[++i]);
+        } else if (arg == "--synthetic-frames" && i + 1 < argc) {
+            config.synthetic_frames = std::stoi(argv[++i]);
+        } else if (arg == "--synthetic-size" && i + 1 < argc) {
+            std::string size = argv[++i];
+            size_t separator = size.find('x');
+            if (separator != std::string::npos) {
+                config.scene.frame_size = cv::Size(std::stoi(size.substr(0, separator)), std::stoi(size.substr(separator + 1)));
+            }
+        } else if (arg == "--compile-calibration") {
+            config.compile_calibration = true;
+        } else if (arg == "--calibration-bundle" && i + 1 < argc) {
+            config.calibration_bundle = argv[++i];
+        } else if (arg == "--metrics-interval" && i + 1 < argc) {
+            config.metrics_interval = std::stod(argv[++i]);
+        } else if (arg == "--metrics-file" && i + 1 < argc) {
+            config.metrics_file = argv[++i];
+        } else if (arg == "--metrics-socket" && i + 1 < argc) {
+            config.metrics_socket = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            config.trace_output = argv[++i];
+        } else if (arg == "--trace-events" && i + 1 < argc) {
+            config.trace_events = std::stoul(argv[++i]);
+        } else if (arg == "--ground-truth" && i + 1 < argc) {
+            config.ground_truth = argv[++i];
+        } else if (arg == "--evaluate" && i + 1 < argc) {
+            config.evaluate_input = argv[++i];
+        } else if (arg == "--max-rmse" && i + 1 < argc) {
+            config.evaluation.max_rmse_mm = std::stod(argv[++i]);
+        } else if (arg == "--max-p95" && i + 1 < argc) {
+            config.evaluation.max_p95_mm = std::stod(argv[++i]);
+        } else if (arg == "--segment-frames" && i + 1 < argc) {
+            config.evaluation.segment_frames = std::stoi(argv[++i]);
+        } else if (arg == "--errors-output" && i + 1 < argc) {
+            config.evaluation.errors_output = argv[++i];
+        } else if (arg == "--output" && i + 1 < argc) {
+            config.trajectory_output = argv[++i];
+        } else if (arg == "--quality-output" && i + 1 < argc) {
+            config.quality_output = argv[++i];
+        } else if (arg == "--no-display") {
+            config.display = false;
+        } else if (arg == "--record" && i + 1 < argc) {
+            config.record_output = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            config.replay_input = argv[++i];
+        } else if (arg == "--detection" && i + 1 < argc) {
+            if (!loadDetectionParams(argv[++i], config.detection)) {
+                std::exit(1);
+            }
+        } else if (arg == "--detection-tile-rows" && i + 1 < argc) {
+            config.detection.tile_rows = std::stoi(argv[++i]);
+        } else if (arg == "--tune") {
+            config.tune = true;
+        } else if (arg == "--tune-frames" && i + 1 < argc) {
+            config.tuner.frames = std::stoi(argv[++i]);
+        } else if (arg == "--tune-samples" && i + 1 < argc) {
+            config.tuner.samples = std::stoi(argv[++i]);
+        } else if (arg == "--tune-seed" && i + 1 < argc) {
+            config.tuner.seed = static_cast<unsigned int>(std::stoul(argv[++i]));
+        } else if (arg == "--tune-output" && i + 1 < argc) {
+            config.tuner.output = argv[++i];
+        } else if (arg == "--tune-front" && i + 1 < argc) {
+            config.tuner.front_output = argv[++i];
+        } else if (arg == "--quorum" && i + 1 < argc) {
+            config.quorum.quorum = std::stoi(argv[++i]);
+        } else if (arg == "--quorum-window" && i + 1 < argc) {
+            config.quorum.window = std::stoi(argv[++i]);
+        } else if (arg == "--quorum-refine" && i + 1 < argc) {
+            config.quorum.refined_output = argv[++i];
+        } else if (arg == "--cache" && i + 1 < argc) {
+            config.cache_dir = argv[++i];
+        } else {
+            std::cerr << "Ignoring unknown option: " << arg << std::endl;
+        }
+    }
+    return config;
+}
+
+#endif // PIPELINE_CONFIG_H
@@ -0,0 +1,220 @@
+#ifndef QUALITY_H
+#define QUALITY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "camera_state.h"
+
+// Geometry quality of a single triangulated point
+struct TriangulationQuality {
+    std::vector<double> reprojection_errors; // Per camera reprojection error in pixels, NaN without a measurement
+    double triangulation_angle = 0.0; // Widest angle between two viewing rays, in degrees
+    double condition_number = 0.0; // sigma_max / sigma_3 of the DLT system, 0 when no DLT was solved
+};
+
+// Function to compute the reprojection errors and the triangulation angle of a point. Cameras with a
+// zero valid flag get a NaN error and no viewing ray, valid == nullptr counts every camera.
+inline void computeGeometryQuality(const cv::Matx34d* projections, const cv::Vec3d* centers,
+                                   const cv::Point2d* imagePoints, const uint8_t* valid, size_t cameras_num,
+                                   const cv::Point3d& point3D, TriangulationQuality& quality) {
+    quality.reprojection_errors.assign(cameras_num, std::numeric_limits<double>::quiet_NaN());
+
+    cv::Vec3d point(point3D.x, point3D.y, point3D.z);
+    cv::Vec4d X(point3D.x, point3D.y, point3D.z, 1.0);
+    double min_cos = 1.0;
+    for (size_t i = 0; i < cameras_num; ++i) {
+        if (valid && !valid[i]) {
+            continue;
+        }
+        cv::Vec3d x = projections[i] * X;
+        quality.reprojection_errors[i] = std::hypot(x[0] / x[2] - imagePoints[i].x, x[1] / x[2] - imagePoints[i].y);
+
+        cv::Vec3d ray = cv::normalize(point - centers[i]);
+        for (size_t j = 0; j < i; ++j) {
+            if (valid && !valid[j]) {
+                continue;
+            }
+            min_cos = std::min(min_cos, ray.dot(cv::normalize(point - centers[j])));
+        }
+    }
+    quality.triangulation_angle = std::acos(std::clamp(min_cos, -1.0, 1.0)) * 180.0 / CV_PI;
+}
+
+// Function to set the condition number from the singular values of the DLT, left at 0 without them
+inline void setConditionNumber(const cv::Mat& singularValues, TriangulationQuality& quality) {
+    // The point is well defined when sigma_4 is small, so the conditioning that matters is
+    // how far the remaining singular values are from collapsing onto the null space.
+    quality.condition_number = 0.0;
+    if (!singularValues.empty()) {
+        double sigma_max = singularValues.at<double>(0);
+        double sigma_3 = singularValues.at<double>(2);
+        quality.condition_number = sigma_3 > 0.0 ? sigma_max / sigma_3 : std::numeric_limits<double>::infinity();
+    }
+}
+
+// Function to compute the quality of a triangulated point from the DLT inputs.
+// Without singular values (point not from a DLT) the condition number is left at 0.
+void computeTriangulationQuality(const std::vector<cv::Mat>& projectionMatrices,
+                                 const std::vector<cv::Point2d>& imagePoints,
+                                 const cv::Mat& singularValues,
+                                 const cv::Point3d& point3D,
+                                 TriangulationQuality& quality) {
+    std::vector<cv::Matx34d> projections;
+    std::vector<cv::Vec3d> centers;
+    for (const cv::Mat& P : projectionMatrices) {
+        projections.push_back(cv::Matx34d(P));
+        centers.push_back(cameraCenter(projections.back()));
+    }
+    setConditionNumber(singularValues, quality);
+    computeGeometryQuality(projections.data(), centers.data(), imagePoints.data(), nullptr, projections.size(),
+                           point3D, quality);
+}
+
+// Function to compute the quality of a point from this frame's geometry with the camera centers cached
+// in the block. Only the cameras with a valid observation are measured.
+void computeTriangulationQuality(const CameraGeometryBlock& geometry,
+                                 const cv::Mat& singularValues,
+                                 const cv::Point3d& point3D,
+                                 TriangulationQuality& quality) {
+    setConditionNumber(singularValues, quality);
+    computeGeometryQuality(geometry.projections.data(), geometry.camera_centers.data(), geometry.image_points.data(),
+                           geometry.valid.data(), geometry.size(), point3D, quality);
+}
+
+// Fixed bin histogram over a rolling window of the most recent samples
+class RollingHistogram {
+public:
+    RollingHistogram(double bin_width = 0.5, int bins_num = 40, size_t window = 300)
+    : bin_width(bin_width), counts(bins_num + 1, 0), samples(window, 0), window(window) {}
+
+    void add(double value) {
+        int bin = binIndex(value);
+        if (filled == window) {
+            counts[samples[next]]--;
+        } else {
+            filled++;
+        }
+        samples[next] = bin;
+        counts[bin]++;
+        next = (next + 1) % window;
+        sum += value;
+        total++;
+    }
+
+    // Value below which the given fraction of the windowed samples fall (bin upper edge)
+    double percentile(double fraction) const {
+        if (filled == 0) {
+            return 0.0;
+        }
+        size_t target = static_cast<size_t>(std::ceil(fraction * filled));
+        size_t seen = 0;
+        for (size_t bin = 0; bin < counts.size(); ++bin) {
+            seen += counts[bin];
+            if (seen >= target) {
+                return (bin + 1) * bin_width;
+            }
+        }
+        return counts.size() * bin_width;
+    }
+
+    // Mean over every sample ever added, not just the window
+    double mean() const { return total ? sum / total : 0.0; }
+    double binWidth() const { return bin_width; }
+    const std::vector<size_t>& binCounts() const { return counts; }
+
+private:
+    int binIndex(double value) const {
+        int last = static_cast<int>(counts.size()) - 1; // Overflow bin
+        if (!(value >= 0.0)) {
+            return last;
+        }
+        return std::min(static_cast<int>(value / bin_width), last);
+    }
+
+    double bin_width;
+    std::vector<size_t> counts;
+    std::vector<int> samples; // Bin of each sample in the window
+    size_t window;
+    size_t filled = 0;
+    size_t next = 0;
+    double sum = 0.0;
+    size_t total = 0;
+};
+
+// Aggregates triangulation quality per camera over time
+class QualityMonitor {
+public:
+    explicit QualityMonitor(size_t cameras_num)
+    : reprojection_histograms(cameras_num),
+      angle_histogram(5.0, 36),
+      condition_histogram(1.0, 20) {}
+
+    void record(const TriangulationQuality& quality) {
+        // Cameras without a measurement this frame have nothing to reproject against
+        for (size_t i = 0; i < quality.reprojection_errors.size() && i < reprojection_histograms.size(); ++i) {
+            if (!std::isnan(quality.reprojection_errors[i])) {
+                reprojection_histograms[i].add(quality.reprojection_errors[i]);
+            }
+        }
+        angle_histogram.add(quality.triangulation_angle);
+        // Condition numbers span orders of magnitude, bin them by log10. Points not from a DLT have none.
+        if (quality.condition_number > 0.0) {
+            condition_histogram.add(std::log10(std::max(quality.condition_number, 1.0)));
+        }
+    }
+
+    const RollingHistogram& cameraHistogram(size_t camera) const { return reprojection_histograms[camera]; }
+
+    // Print the rolling p50/p95 reprojection error of each camera
+    void printSummary() const {
+        for (size_t i = 0; i < reprojection_histograms.size(); ++i) {
+            const RollingHistogram& h = reprojection_histograms[i];
+            std::cout << "Camera " << i + 1 << " reprojection error p50: " << h.percentile(0.5)
+                      << " px, p95: " << h.percentile(0.95) << " px" << std::endl;
+        }
+    }
+
+    // Export all histograms as CSV rows: metric,camera,bin_low,bin_high,count
+    bool exportCsv(const std::string& csvFilePath) const {
+        std::ofstream file(csvFilePath);
+        if (!file) {
+            std::cerr << "Could not open histogram file: " << csvFilePath << std::endl;
+            return false;
+        }
+        file << "metric,camera,bin_low,bin_high,count\n";
+        for (size_t i = 0; i < reprojection_histograms.size(); ++i) {
+            writeHistogram(file, "reprojection_error_px", static_cast<int>(i + 1), reprojection_histograms[i]);
+        }
+        writeHistogram(file, "triangulation_angle_deg", 0, angle_histogram);
+        writeHistogram(file, "log10_condition_number", 0, condition_histogram);
+        return true;
+    }
+
+private:
+    static void writeHistogram(std::ofstream& file, const std::string& metric, int camera, const RollingHistogram& h) {
+        const std::vector<size_t>& counts = h.binCounts();
+        for (size_t bin = 0; bin < counts.size(); ++bin) {
+            double low = bin * h.binWidth();
+            file << metric << "," << camera << "," << low << ",";
+            if (bin + 1 == counts.size()) {
+                file << "inf";
+            } else {
+                file << low + h.binWidth();
+            }
+            file << "," << counts[bin] << "\n";
+        }
+    }
+
+    std::vector<RollingHistogram> reprojection_histograms;
+    RollingHistogram angle_histogram;
+    RollingHistogram condition_histogram;
+};
+
+#endif // QUALITY_H
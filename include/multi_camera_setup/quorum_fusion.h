@@ -0,0 +1,207 @@
+#ifndef QUORUM_FUSION_H
+#define QUORUM_FUSION_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "camera_state.h"
+#include "dlt.h"
+#include "quality.h"
+#include "ring_queue.h"
+
+// Quorum fusion lets every camera track its frames on its own thread and triangulates a frame as soon as
+// enough valid observations of it have arrived, so one slow camera (a keyframe, I/O jitter) no longer
+// holds up the 3D output of the others. The late observations can still refine the point afterwards.
+
+// Options of the quorum fusion
+struct QuorumConfig {
+    int quorum = 0; // Valid observations that trigger a frame's triangulation, 0 turns quorum fusion off
+    int window = 4; // Frames a camera may run ahead of the oldest frame some camera has not reported yet
+    std::string refined_output; // CSV of the points triangulated from every camera, empty disables refinement
+};
+
+// One camera's result for one frame, handed from the camera's thread to fusion
+struct CameraObservation {
+    int frame = -1;
+    int camera = 0; // Index into the rig, 0 based
+    cv::Point2d point; // Undistorted position
+    uint8_t valid = 0; // Backed by a measurement this frame
+};
+
+// Function to triangulate the valid observations of a frame. With fewer than two valid ones it falls back
+// to every observation, the cameras' own predictions included. The quality is measured against the valid
+// observations only.
+inline cv::Point3d triangulateValidObservations(const CameraGeometryBlock& geometry,
+                                                TriangulationQuality* quality = nullptr) {
+    std::vector<cv::Matx34d> projections;
+    std::vector<cv::Point2d> points;
+    for (size_t i = 0; i < geometry.size(); ++i) {
+        if (geometry.valid[i]) {
+            projections.push_back(geometry.projections[i]);
+            points.push_back(geometry.image_points[i]);
+        }
+    }
+    if (points.size() < 2) {
+        projections = geometry.projections;
+        points = geometry.image_points;
+    }
+    cv::Vec4d singularValues;
+    cv::Point3d point3D = selectDltKernel(points.size())(projections.data(), points.data(), points.size(),
+                                                         singularValues);
+    if (quality) {
+        computeTriangulationQuality(geometry, cv::Mat(4, 1, CV_64F, singularValues.val), point3D, *quality);
+    }
+    return point3D;
+}
+
+// Single threaded bookkeeping of the frames in flight. Observations of a frame are collected in a ring
+// slot; the quorum sink runs once the frame and all frames before it have enough valid observations (or
+// every camera reported), the complete sink once every camera reported. Both sinks see the frames in
+// order. Camera threads report their frames in order and call waitForWindow before each one, which
+// bounds the frames in flight to the slots.
+class QuorumFusion {
+public:
+    // Observations of the frame, cameras that have not reported it are marked invalid
+    typedef std::function<void(int frame, const CameraGeometryBlock& observations)> Sink;
+
+    QuorumFusion(const CameraGeometryBlock& rig_geometry, const QuorumConfig& config, Sink on_quorum, Sink on_complete)
+    : quorum(std::min(std::max(config.quorum, 2), static_cast<int>(rig_geometry.size()))),
+      window(std::max(config.window, 1)), slots(window), on_quorum(std::move(on_quorum)),
+      on_complete(std::move(on_complete)), arrivals(rig_geometry.size(), 0), late_arrivals(rig_geometry.size(), 0) {
+        for (Slot& slot : slots) {
+            slot.observations.setProjectionMatrices(rig_geometry.projection_matrices);
+            slot.arrived.assign(rig_geometry.size(), 0);
+        }
+    }
+
+    QuorumFusion(const QuorumFusion&) = delete;
+    QuorumFusion& operator=(const QuorumFusion&) = delete;
+
+    int quorumSize() const { return quorum; }
+    int windowSize() const { return window; }
+
+    // Frames every camera has reported, read by the camera threads
+    int completedFrames() const { return completed.load(std::memory_order_acquire); }
+
+    // Method for a camera thread to wait until frame_index fits the window of frames in flight
+    void waitForWindow(int frame_index) {
+        window_open.waitUntil([&] { return frame_index < completedFrames() + window; });
+    }
+
+    // Method to take one observation, runs the sinks the frame is ready for
+    void add(const CameraObservation& observation) {
+        auto now = std::chrono::steady_clock::now();
+        Slot& slot = slots[observation.frame % window];
+        if (slot.frame != observation.frame) {
+            slot.frame = observation.frame;
+            slot.arrived_num = 0;
+            slot.valid_num = 0;
+            slot.fired = false;
+            slot.first_arrival = now;
+            std::fill(slot.arrived.begin(), slot.arrived.end(), 0);
+            std::fill(slot.observations.valid.begin(), slot.observations.valid.end(), 0);
+        }
+
+        size_t camera = static_cast<size_t>(observation.camera);
+        slot.observations.image_points[camera] = observation.point;
+        slot.observations.valid[camera] = observation.valid;
+        slot.arrived[camera] = 1;
+        slot.arrived_num++;
+        slot.valid_num += observation.valid ? 1 : 0;
+        arrivals[camera]++;
+
+        if (slot.fired) {
+            late_arrivals[camera]++;
+        }
+
+        // A frame may reach its quorum before an earlier one whose fast cameras lost the ball, it then
+        // waits for that one so the output stays in frame order
+        for (;;) {
+            Slot& next = slots[next_fire % window];
+            if (next.frame != next_fire || !(next.valid_num >= quorum || isComplete(next))) {
+                break;
+            }
+            next.fired = true;
+            quorum_wait_ms.push_back(std::chrono::duration<double, std::milli>(now - next.first_arrival).count());
+            if (!isComplete(next)) {
+                fired_early++;
+            }
+            on_quorum(next.frame, next.observations);
+            next_fire++;
+        }
+
+        if (isComplete(slot)) {
+            complete_wait_ms.push_back(std::chrono::duration<double, std::milli>(now - slot.first_arrival).count());
+            on_complete(slot.frame, slot.observations);
+            completed.fetch_add(1, std::memory_order_acq_rel);
+            window_open.notify();
+        }
+    }
+
+    // Method to print how often the quorum fired before the last camera, the wait for the quorum and for
+    // every camera since a frame's first observation, and how often each camera arrived after the quorum
+    void printSummary(const std::vector<std::string>& camera_names) const {
+        size_t frames = complete_wait_ms.size();
+        if (frames == 0) {
+            return;
+        }
+        auto percentile = [](std::vector<double> values, double q) {
+            std::sort(values.begin(), values.end());
+            return values[static_cast<size_t>(q * (values.size() - 1))];
+        };
+        std::ios::fmtflags flags = std::cout.flags();
+        std::streamsize precision = std::cout.precision();
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "Quorum fusion: " << quorum << " of " << arrivals.size() << " cameras, " << fired_early << " of "
+                  << frames << " frames fused before the last camera (" << 100.0 * fired_early / frames << "%)"
+                  << std::endl;
+        std::cout << "  wait for quorum p50 " << percentile(quorum_wait_ms, 0.5) << " ms, p99 "
+                  << percentile(quorum_wait_ms, 0.99) << " ms; wait for all cameras p50 "
+                  << percentile(complete_wait_ms, 0.5) << " ms, p99 " << percentile(complete_wait_ms, 0.99) << " ms"
+                  << std::endl;
+        for (size_t i = 0; i < arrivals.size(); ++i) {
+            std::string name = i < camera_names.size() ? camera_names[i] : std::to_string(i + 1);
+            std::cout << "  " << name << " late " << (arrivals[i] ? 100.0 * late_arrivals[i] / arrivals[i] : 0.0)
+                      << "% (" << late_arrivals[i] << " of " << arrivals[i] << " frames)" << std::endl;
+        }
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+
+private:
+    struct Slot {
+        int frame = -1;
+        CameraGeometryBlock observations;
+        std::vector<uint8_t> arrived;
+        int arrived_num = 0;
+        int valid_num = 0;
+        bool fired = false;
+        std::chrono::steady_clock::time_point first_arrival;
+    };
+
+    bool isComplete(const Slot& slot) const { return slot.arrived_num == static_cast<int>(slot.arrived.size()); }
+
+    int quorum;
+    int window;
+    int next_fire = 0; // Oldest frame not fused yet
+    std::vector<Slot> slots; // Frame f uses slot f % window
+    Sink on_quorum;
+    Sink on_complete;
+    std::atomic<int> completed{0};
+    BlockingWaitPolicy window_open;
+
+    std::vector<size_t> arrivals; // Observations per camera
+    std::vector<size_t> late_arrivals; // Observations that arrived after their frame was fused
+    size_t fired_early = 0;
+    std::vector<double> quorum_wait_ms;
+    std::vector<double> complete_wait_ms;
+};
+
+#endif // QUORUM_FUSION_H
@@ -0,0 +1,363 @@
+#ifndef RING_QUEUE_H
+#define RING_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Bounded lock-free ring queues for handing work between pipeline stages running on their own threads:
+// SpscQueue for one producer and one consumer (e.g. a camera's decode feeding its detection) and
+// MpscQueue for many producers and one consumer (e.g. the cameras' observations feeding fusion).
+// Both are fixed size rings of default constructible T, so a full queue pushes back on its producers.
+// The wait policy decides how a blocking push or pop waits: SpinWaitPolicy keeps the thread hot for
+// the lowest hand-off latency, BlockingWaitPolicy sleeps on a condition variable after a short spin.
+
+const size_t QUEUE_CACHE_LINE = 64;
+
+inline void cpuRelax() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+inline size_t roundUpToPowerOfTwo(size_t value) {
+    size_t power = 1;
+    while (power < value) {
+        power <<= 1;
+    }
+    return power;
+}
+
+// Busy waits with a pause, then yields the core after a while so an oversubscribed machine still progresses
+struct SpinWaitPolicy {
+    template <typename Ready>
+    void waitUntil(Ready ready) {
+        for (unsigned spins = 0; !ready(); ++spins) {
+            if (spins < 1024) {
+                cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void notify() {}
+};
+
+// Spins briefly, then sleeps until notified. Notifying costs one uncontended atomic add while nobody sleeps.
+struct BlockingWaitPolicy {
+    template <typename Ready>
+    void waitUntil(Ready ready) {
+        for (unsigned spins = 0; spins < 128; ++spins) {
+            if (ready()) {
+                return;
+            }
+            cpuRelax();
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        // Both sides read-modify-write sleepers, so either the waker sees this sleeper or the sleeper
+        // sees the state the waker published before it
+        sleepers.fetch_add(1);
+        condition.wait(lock, ready);
+        sleepers.fetch_sub(1);
+    }
+
+    void notify() {
+        if (sleepers.fetch_add(0) > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            condition.notify_all();
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::atomic<int> sleepers{0};
+};
+
+// Single producer single consumer ring. Each side caches the other side's index and only reloads it
+// when the cached value says the ring is full (or empty), so a steady stream touches the shared
+// cache lines once per batch rather than once per item.
+template <typename T, typename WaitPolicy = SpinWaitPolicy>
+class SpscQueue {
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+        : slots(roundUpToPowerOfTwo(std::max<size_t>(capacity, 2))), mask(slots.size() - 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    size_t capacity() const { return slots.size(); }
+
+    // Method to move up to count items in without waiting, returns how many fit
+    size_t tryPushBatch(T* items, size_t count) {
+        size_t tail = producer.tail.load(std::memory_order_relaxed);
+        size_t free = capacity() - (tail - producer.cached_head);
+        if (free < count) {
+            producer.cached_head = consumer.head.load(std::memory_order_acquire);
+            free = capacity() - (tail - producer.cached_head);
+        }
+        size_t pushed = std::min(free, count);
+        for (size_t i = 0; i < pushed; ++i) {
+            slots[(tail + i) & mask] = std::move(items[i]);
+        }
+        if (pushed > 0) {
+            producer.tail.store(tail + pushed, std::memory_order_release);
+            not_empty.notify();
+        }
+        return pushed;
+    }
+
+    bool tryPush(T item) { return tryPushBatch(&item, 1) == 1; }
+
+    // Method to move all count items in, waiting while the queue is full. Returns false if it was closed.
+    bool pushBatch(T* items, size_t count) {
+        while (count > 0) {
+            size_t pushed = tryPushBatch(items, count);
+            items += pushed;
+            count -= pushed;
+            if (count > 0) {
+                not_full.waitUntil([&] { return hasSpace() || isClosed(); });
+                if (isClosed()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool push(T item) { return pushBatch(&item, 1); }
+
+    // Method to move up to max_count items out without waiting, returns how many it took
+    size_t tryPopBatch(T* items, size_t max_count) {
+        size_t head = consumer.head.load(std::memory_order_relaxed);
+        size_t available = consumer.cached_tail - head;
+        if (available < max_count) {
+            consumer.cached_tail = producer.tail.load(std::memory_order_acquire);
+            available = consumer.cached_tail - head;
+        }
+        size_t popped = std::min(available, max_count);
+        for (size_t i = 0; i < popped; ++i) {
+            items[i] = std::move(slots[(head + i) & mask]);
+        }
+        if (popped > 0) {
+            consumer.head.store(head + popped, std::memory_order_release);
+            not_full.notify();
+        }
+        return popped;
+    }
+
+    bool tryPop(T& item) { return tryPopBatch(&item, 1) == 1; }
+
+    // Method to wait for at least one item and move up to max_count out. Returns 0 only once the
+    // queue is closed and drained.
+    size_t popBatch(T* items, size_t max_count) {
+        for (;;) {
+            size_t popped = tryPopBatch(items, max_count);
+            if (popped > 0) {
+                return popped;
+            }
+            not_empty.waitUntil([&] { return hasItems() || isClosed(); });
+            if (isClosed() && !hasItems()) {
+                return 0;
+            }
+        }
+    }
+
+    bool pop(T& item) { return popBatch(&item, 1) == 1; }
+
+    // Method to end the stream: blocked producers give up, the consumer drains what is left
+    void close() {
+        closed.store(true, std::memory_order_release);
+        not_empty.notify();
+        not_full.notify();
+    }
+
+    bool isClosed() const { return closed.load(std::memory_order_acquire); }
+
+    size_t sizeApprox() const {
+        return producer.tail.load(std::memory_order_acquire) - consumer.head.load(std::memory_order_acquire);
+    }
+
+private:
+    bool hasItems() const { return sizeApprox() > 0; }
+    bool hasSpace() const { return sizeApprox() < capacity(); }
+
+    // Written by the producer, the head is its cached copy
+    struct alignas(QUEUE_CACHE_LINE) ProducerSide {
+        std::atomic<size_t> tail{0};
+        size_t cached_head = 0;
+    };
+    // Written by the consumer, the tail is its cached copy
+    struct alignas(QUEUE_CACHE_LINE) ConsumerSide {
+        std::atomic<size_t> head{0};
+        size_t cached_tail = 0;
+    };
+
+    ProducerSide producer;
+    ConsumerSide consumer;
+    std::vector<T> slots;
+    size_t mask;
+    std::atomic<bool> closed{false};
+    WaitPolicy not_empty;
+    WaitPolicy not_full;
+};
+
+// Multiple producer single consumer ring. Producers claim slots by advancing the tail with a CAS, one
+// claim per batch, and publish each slot by storing its sequence number. The consumer takes slots
+// strictly in order as they are published, so a producer preempted between claim and publish delays
+// the items behind its slot but never loses or reorders them.
+template <typename T, typename WaitPolicy = SpinWaitPolicy>
+class MpscQueue {
+public:
+    // Capacity is rounded up to a power of two
+    explicit MpscQueue(size_t capacity)
+        : slots(roundUpToPowerOfTwo(std::max<size_t>(capacity, 2))), mask(slots.size() - 1) {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed); // Slot i is free for position i
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    size_t capacity() const { return slots.size(); }
+
+    // Method to move up to count items in without waiting, returns how many fit. The items of one
+    // batch stay together in the queue.
+    size_t tryPushBatch(T* items, size_t count) {
+        size_t tail = producers.tail.load(std::memory_order_relaxed);
+        size_t claimed;
+        for (;;) {
+            size_t head = consumer.head.load(std::memory_order_acquire);
+            claimed = std::min(count, capacity() - (tail - head));
+            if (claimed == 0) {
+                return 0;
+            }
+            if (producers.tail.compare_exchange_weak(tail, tail + claimed, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        for (size_t i = 0; i < claimed; ++i) {
+            Slot& slot = slots[(tail + i) & mask];
+            slot.value = std::move(items[i]);
+            slot.sequence.store(tail + i + 1, std::memory_order_release);
+        }
+        not_empty.notify();
+        return claimed;
+    }
+
+    bool tryPush(T item) { return tryPushBatch(&item, 1) == 1; }
+
+    // Method to move all count items in, waiting while the queue is full. Returns false if it was closed.
+    bool pushBatch(T* items, size_t count) {
+        while (count > 0) {
+            size_t pushed = tryPushBatch(items, count);
+            items += pushed;
+            count -= pushed;
+            if (count > 0) {
+                not_full.waitUntil([&] { return hasSpace() || isClosed(); });
+                if (isClosed()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool push(T item) { return pushBatch(&item, 1); }
+
+    // Method to move up to max_count published items out without waiting, returns how many it took
+    size_t tryPopBatch(T* items, size_t max_count) {
+        size_t head = consumer.head.load(std::memory_order_relaxed);
+        size_t popped = 0;
+        while (popped < max_count) {
+            Slot& slot = slots[(head + popped) & mask];
+            if (slot.sequence.load(std::memory_order_acquire) != head + popped + 1) {
+                break; // Not published yet
+            }
+            items[popped] = std::move(slot.value);
+            popped++;
+        }
+        if (popped > 0) {
+            consumer.head.store(head + popped, std::memory_order_release);
+            not_full.notify();
+        }
+        return popped;
+    }
+
+    bool tryPop(T& item) { return tryPopBatch(&item, 1) == 1; }
+
+    // Method to wait for at least one item and move up to max_count out. Returns 0 only once the
+    // queue is closed and drained.
+    size_t popBatch(T* items, size_t max_count) {
+        for (;;) {
+            size_t popped = tryPopBatch(items, max_count);
+            if (popped > 0) {
+                return popped;
+            }
+            not_empty.waitUntil([&] { return isPublished() || isClosed(); });
+            if (isClosed() && !isPublished() && sizeApprox() == 0) {
+                return 0;
+            }
+        }
+    }
+
+    bool pop(T& item) { return popBatch(&item, 1) == 1; }
+
+    // Method to end the stream: blocked producers give up, the consumer drains what is left
+    void close() {
+        closed.store(true, std::memory_order_release);
+        not_empty.notify();
+        not_full.notify();
+    }
+
+    bool isClosed() const { return closed.load(std::memory_order_acquire); }
+
+    // Claimed items, including ones still being written
+    size_t sizeApprox() const {
+        return producers.tail.load(std::memory_order_acquire) - consumer.head.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0}; // position + 1 once the item for position is published
+        T value{};
+    };
+
+    bool isPublished() const {
+        size_t head = consumer.head.load(std::memory_order_relaxed);
+        return slots[head & mask].sequence.load(std::memory_order_acquire) == head + 1;
+    }
+    bool hasSpace() const { return sizeApprox() < capacity(); }
+
+    struct alignas(QUEUE_CACHE_LINE) ProducerSide {
+        std::atomic<size_t> tail{0}; // Next position to claim
+    };
+    struct alignas(QUEUE_CACHE_LINE) ConsumerSide {
+        std::atomic<size_t> head{0}; // Next position to take
+    };
+
+    ProducerSide producers;
+    ConsumerSide consumer;
+    std::vector<Slot> slots;
+    size_t mask;
+    std::atomic<bool> closed{false};
+    WaitPolicy not_empty;
+    WaitPolicy not_full;
+};
+
+#endif // RING_QUEUE_H
@@ -0,0 +1,130 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+#include "camera.h"
+#include "utils.h"
+
+// Tuning of the adaptive tracker scheduler
+struct SchedulerConfig {
+    double frame_budget_ms = 10.0; // Tracking CPU time all cameras together may spend per frame
+    int max_frames_without_detection = 15; // Force a detection on a camera after this many frames
+    double variance_weight = 1.0; // Score per pixel of position standard deviation
+    double flow_error_weight = 4.0; // Score per pixel of forward-backward flow error
+    double staleness_weight = 0.5; // Score per frame since the last detection
+    double cost_smoothing = 0.1; // Weight of a new sample in the per mode cost averages
+};
+
+// Picks a tracker per camera and frame so the expected tracking cost fits a frame budget.
+// Cameras start from the cheapest tracker that keeps their track alive, the most certain
+// tracks are dropped to prediction while over budget, and the remaining budget buys
+// detections for the most uncertain cameras, the round-robin camera of checkDetectionActive first.
+class AdaptiveScheduler {
+public:
+    explicit AdaptiveScheduler(const SchedulerConfig& config = SchedulerConfig())
+    : config(config) {}
+
+    // Method to set camera.state->tracker_mode (and is_detection_active) for every camera for this frame,
+    // interframe_mode is the tracker used between detections (OpticalFlow or CorrelationFilter)
+    void schedule(std::vector<Camera>& cameras, int frame_index, int detection_period,
+                  TrackerMode interframe_mode = TrackerMode::OpticalFlow) {
+        const size_t cameras_num = cameras.size();
+        scores.resize(cameras_num);
+        order.resize(cameras_num);
+        double total = 0.0;
+
+        for (size_t i = 0; i < cameras_num; ++i) {
+            Camera& camera = cameras[i];
+            camera.state->is_detection_active = checkDetectionActive(frame_index, detection_period, camera);
+
+            if (!camera.state->is_tracking) {
+                camera.state->tracker_mode = TrackerMode::FullDetection;
+            } else if (camera.canTrackWith(interframe_mode)) {
+                camera.state->tracker_mode = interframe_mode;
+            } else {
+                camera.state->tracker_mode = TrackerMode::RoiDetection;
+            }
+            scores[i] = uncertaintyScore(camera);
+            total += cost(camera.state->tracker_mode);
+        }
+
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return scores[a] < scores[b]; });
+
+        // Over budget: the most certain cameras skip image work this frame. A camera that lost the ball
+        // keeps its detection, prediction alone would leave it lost until it goes stale. Two cameras always
+        // keep measuring, the triangulation needs two views and predictions alone drift off the ball.
+        size_t measuring = cameras_num;
+        for (size_t k = 0; k < cameras_num && total > config.frame_budget_ms && measuring > 2; ++k) {
+            Camera& camera = cameras[order[k]];
+            if (!camera.state->is_tracking ||
+                camera.state->frames_since_detection >= config.max_frames_without_detection) {
+                continue;
+            }
+            total -= cost(camera.state->tracker_mode) - cost(TrackerMode::PredictOnly);
+            camera.state->tracker_mode = TrackerMode::PredictOnly;
+            measuring--;
+        }
+
+        // Under budget: buy detections, round-robin camera first, then by decreasing uncertainty
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            if (cameras[a].state->is_detection_active != cameras[b].state->is_detection_active) {
+                return cameras[a].state->is_detection_active;
+            }
+            return scores[a] > scores[b];
+        });
+        for (size_t k = 0; k < cameras_num; ++k) {
+            Camera& camera = cameras[order[k]];
+            if (camera.state->tracker_mode == TrackerMode::FullDetection || camera.state->tracker_mode == TrackerMode::PredictOnly) {
+                continue;
+            }
+            bool stale = camera.state->frames_since_detection >= config.max_frames_without_detection;
+            TrackerMode upgrade = (camera.state->is_detection_active || stale) ? TrackerMode::FullDetection
+                                                                        : TrackerMode::RoiDetection;
+            if (upgrade == camera.state->tracker_mode) {
+                continue;
+            }
+            double delta = cost(upgrade) - cost(camera.state->tracker_mode);
+            if (total + delta <= config.frame_budget_ms || stale) {
+                total += delta;
+                camera.state->tracker_mode = upgrade;
+            }
+        }
+    }
+
+    // Method to fold the measured per camera tracking times into the per mode cost estimates. A camera
+    // without a frame was not tracked, its tracking time is from an earlier frame.
+    void recordCosts(const std::vector<Camera>& cameras) {
+        for (const Camera& camera : cameras) {
+            if (camera.current_frame.empty()) {
+                continue;
+            }
+            double& estimate = cost_ms[static_cast<int>(camera.state->tracker_mode)];
+            estimate += config.cost_smoothing * (camera.state->tracking_ms - estimate);
+        }
+    }
+
+    double cost(TrackerMode mode) const { return cost_ms[static_cast<int>(mode)]; }
+
+private:
+    double uncertaintyScore(const Camera& camera) const {
+        if (!camera.state->is_tracking) {
+            return std::numeric_limits<double>::infinity();
+        }
+        return config.variance_weight * std::sqrt(camera.state->kalman_fitler.positionVariance()) +
+               config.flow_error_weight * camera.flow_tracker.forwardBackwardError() +
+               config.staleness_weight * camera.state->frames_since_detection;
+    }
+
+    SchedulerConfig config;
+    // Initial guesses in ms for a 1280x1024 camera, refined online by recordCosts
+    double cost_ms[5] = {4.0, 0.5, 0.3, 0.3, 0.01};
+    std::vector<double> scores;
+    std::vector<size_t> order;
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,235 @@
+#ifndef SMOOTHER_H
+#define SMOOTHER_H
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "fixed_kalman.h"
+
+// One forward filter step as the Rauch-Tung-Striebel backward pass needs it
+template <int StateDim>
+struct SmootherStep {
+    typedef cv::Matx<double, StateDim, 1> StateVec;
+    typedef cv::Matx<double, StateDim, StateDim> StateMat;
+
+    int frame_index = 0;
+    StateVec predicted_state; // x(k|k-1)
+    StateMat predicted_covariance; // P(k|k-1)
+    StateMat transition; // F used to predict from k-1 to k
+    StateVec filtered_state; // x(k|k), replaced by x(k|N) when the step is emitted
+    StateMat filtered_covariance; // P(k|k)
+};
+
+// RTS smoother over a stream of filter steps, run in blocks so memory stays bounded.
+// Every emitted step has seen at least `lag` future steps; flush() smooths the tail exactly.
+template <int StateDim>
+class BlockRtsSmoother {
+public:
+    typedef SmootherStep<StateDim> Step;
+    typedef std::function<void(const Step&)> Sink;
+
+    BlockRtsSmoother(size_t block_size, size_t lag, Sink sink)
+    : block_size(std::max<size_t>(block_size, 1)), lag(lag), sink(std::move(sink)) {
+        buffer.reserve(this->block_size + lag);
+        smoothed.resize(this->block_size + lag);
+    }
+
+    void push(const Step& step) {
+        buffer.push_back(step);
+        if (buffer.size() >= block_size + lag) {
+            smoothAndEmit(block_size);
+        }
+    }
+
+    void flush() {
+        smoothAndEmit(buffer.size());
+    }
+
+private:
+    void smoothAndEmit(size_t count) {
+        const size_t n = buffer.size();
+        if (n == 0) {
+            return;
+        }
+
+        // Backward pass from the newest step, which is its own smoothed estimate
+        smoothed[n - 1] = buffer[n - 1].filtered_state;
+        for (size_t k = n - 1; k-- > 0;) {
+            const Step& current = buffer[k];
+            const Step& next = buffer[k + 1];
+            typename Step::StateMat gain = current.filtered_covariance * next.transition.t() *
+                                           next.predicted_covariance.inv(cv::DECOMP_CHOLESKY);
+            smoothed[k] = current.filtered_state + gain * (smoothed[k + 1] - next.predicted_state);
+        }
+
+        for (size_t k = 0; k < count; ++k) {
+            Step out = buffer[k];
+            out.filtered_state = smoothed[k];
+            sink(out);
+        }
+        buffer.erase(buffer.begin(), buffer.begin() + count);
+    }
+
+    size_t block_size;
+    size_t lag;
+    Sink sink;
+    std::vector<Step> buffer;
+    std::vector<typename Step::StateVec> smoothed;
+};
+
+// Tuning of the offline trajectory smoother
+struct TrajectorySmootherConfig {
+    double fps = 30.0; // Sample rate of the trajectory
+    double acceleration_noise = 200.0; // White acceleration noise density (m^2/s^3)
+    double position_sigma = 0.015; // Standard deviation of an input position (m)
+    double gate = 16.0; // Mahalanobis gate on the 3D innovation (chi2 with 3 dof), 0 disables it
+    int max_rejections = 3; // Consecutive gated out samples after which the filter restarts at the first
+    size_t block_size = 256; // Steps emitted per backward pass
+    size_t lag = 64; // Future steps every emitted step is smoothed with
+};
+
+// Function to load an "x,y,z" per line trajectory CSV
+std::vector<cv::Point3d> loadTrajectoryCsv(const std::string& csvFilePath) {
+    std::vector<cv::Point3d> trajectory;
+    std::ifstream file(csvFilePath);
+    if (!file) {
+        std::cerr << "Could not open trajectory file: " << csvFilePath << std::endl;
+        return trajectory;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream values(line);
+        cv::Point3d point;
+        if (values >> point.x >> point.y >> point.z) {
+            trajectory.push_back(point);
+        }
+    }
+    return trajectory;
+}
+
+// Function to smooth a trajectory CSV with a constant velocity filter and a block RTS pass.
+// The input is streamed, so memory does not grow with the length of the recording. Samples outside the
+// gate are replaced by the prediction. A run of max_rejections of them means the track jumped, so the
+// smoothed segment ends before the run and a new one starts at its first sample.
+bool smoothTrajectoryCsv(const std::string& inputPath, const std::string& outputPath,
+                         const TrajectorySmootherConfig& config) {
+    std::ifstream input(inputPath);
+    std::ofstream output(outputPath);
+    if (!input || !output) {
+        std::cerr << "Could not open " << (!input ? inputPath : outputPath) << std::endl;
+        return false;
+    }
+
+    typedef FixedKalmanFilter<6, 3, double> Filter;
+    Filter KF;
+    double dt = 1.0 / config.fps;
+    double q = config.acceleration_noise;
+    for (int i = 0; i < 3; ++i) {
+        KF.transition(i, i + 3) = dt;
+        KF.measurement_matrix(i, i) = 1.0;
+        KF.process_noise(i, i) = q * dt * dt * dt / 3.0;
+        KF.process_noise(i, i + 3) = q * dt * dt / 2.0;
+        KF.process_noise(i + 3, i) = q * dt * dt / 2.0;
+        KF.process_noise(i + 3, i + 3) = q * dt;
+    }
+    KF.measurement_noise = Filter::MeasMat::eye() * (config.position_sigma * config.position_sigma);
+
+    BlockRtsSmoother<6> smoother(config.block_size, config.lag, [&](const SmootherStep<6>& step) {
+        output << step.filtered_state(0) << "," << step.filtered_state(1) << "," << step.filtered_state(2) << "\n";
+    });
+
+    // Start a segment at a sample with an unknown velocity
+    auto start = [&](const Filter::MeasVec& measurement, int frame_index) {
+        KF.state = Filter::StateVec(measurement(0), measurement(1), measurement(2), 0.0, 0.0, 0.0);
+        KF.covariance = Filter::StateMat::eye() * 4.0;
+        for (int i = 0; i < 3; ++i) {
+            KF.covariance(i, i) = config.position_sigma * config.position_sigma;
+        }
+        SmootherStep<6> step;
+        step.frame_index = frame_index;
+        step.transition = Filter::StateMat::eye();
+        step.predicted_state = step.filtered_state = KF.state;
+        step.predicted_covariance = step.filtered_covariance = KF.covariance;
+        smoother.push(step);
+    };
+
+    // Predict to the sample and fuse it unless it falls outside the gate, returns the step
+    auto track = [&](const Filter::MeasVec& measurement, int frame_index, bool gated, bool& rejected) {
+        SmootherStep<6> step;
+        step.frame_index = frame_index;
+        step.transition = KF.transition;
+        KF.predict();
+        step.predicted_state = KF.state;
+        step.predicted_covariance = KF.covariance;
+
+        Filter::MeasVec innovation = measurement - KF.measurement_matrix * KF.state;
+        Filter::MeasMat S = KF.measurement_matrix * KF.covariance * KF.measurement_matrix.t() + KF.measurement_noise;
+        rejected = gated && config.gate > 0.0 && (innovation.t() * S.inv() * innovation)(0) > config.gate;
+        if (!rejected) {
+            KF.correct(measurement);
+        }
+        step.filtered_state = KF.state;
+        step.filtered_covariance = KF.covariance;
+        return step;
+    };
+
+    // Gated out samples wait here until the next accepted one confirms the segment or the run restarts it
+    std::vector<SmootherStep<6>> pending;
+    std::vector<Filter::MeasVec> pending_measurements;
+
+    std::string line;
+    int frame_index = 0;
+    while (std::getline(input, line)) {
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream values(line);
+        Filter::MeasVec measurement;
+        if (!(values >> measurement(0) >> measurement(1) >> measurement(2))) {
+            continue;
+        }
+
+        if (frame_index == 0) {
+            start(measurement, frame_index++);
+            continue;
+        }
+
+        bool rejected = false;
+        SmootherStep<6> step = track(measurement, frame_index, true, rejected);
+        if (!rejected) {
+            for (const SmootherStep<6>& predicted : pending) {
+                smoother.push(predicted);
+            }
+            pending.clear();
+            pending_measurements.clear();
+            smoother.push(step);
+        } else if (static_cast<int>(pending.size()) + 1 < config.max_rejections) {
+            pending.push_back(step);
+            pending_measurements.push_back(measurement);
+        } else {
+            smoother.flush();
+            pending_measurements.push_back(measurement);
+            int first = frame_index - static_cast<int>(pending.size());
+            start(pending_measurements[0], first);
+            for (size_t k = 1; k < pending_measurements.size(); ++k) {
+                smoother.push(track(pending_measurements[k], first + static_cast<int>(k), false, rejected));
+            }
+            pending.clear();
+            pending_measurements.clear();
+        }
+        frame_index++;
+    }
+    for (const SmootherStep<6>& predicted : pending) {
+        smoother.push(predicted);
+    }
+    smoother.flush();
+    return true;
+}
+
+#endif // SMOOTHER_H
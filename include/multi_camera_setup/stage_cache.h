@@ -0,0 +1,210 @@
+#ifndef STAGE_CACHE_H
+#define STAGE_CACHE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "camera_parameters.h"
+#include "pipeline_config.h"
+
+// 64 bit FNV-1a, the key of the stage cache entries
+class Fnv1a64 {
+public:
+    Fnv1a64& add(const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            state = (state ^ bytes[i]) * 1099511628211ull;
+        }
+        return *this;
+    }
+
+    // Scalars only, structs would hash their padding
+    template <typename T>
+    Fnv1a64& add(const T& value) {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "hash fields one by one");
+        return add(&value, sizeof(value));
+    }
+
+    Fnv1a64& add(const std::string& value) {
+        add(value.size());
+        return add(value.data(), value.size());
+    }
+
+    Fnv1a64& add(const std::vector<double>& values) {
+        add(values.size());
+        return add(values.data(), values.size() * sizeof(double));
+    }
+
+    uint64_t digest() const { return state; }
+
+private:
+    uint64_t state = 14695981039346656037ull;
+};
+
+inline std::string hashHex(uint64_t hash) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
+
+// Function to hash the whole content of a file, 0 if it cannot be read
+inline uint64_t hashFileContents(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return 0;
+    }
+    Fnv1a64 hash;
+    std::vector<char> buffer(1 << 20);
+    while (file) {
+        file.read(buffer.data(), buffer.size());
+        hash.add(buffer.data(), static_cast<size_t>(file.gcount()));
+    }
+    return hash.digest();
+}
+
+// On disk cache of stage outputs, content addressed by a hash of everything the stage read:
+// <dir>/<stage>/<key><ext>. Entries are only ever added whole (written aside, then renamed), so an
+// interrupted run leaves no half written entry behind.
+class StageCache {
+public:
+    explicit StageCache(const std::string& dir = std::string()) : dir(dir) {}
+
+    bool isEnabled() const { return !dir.empty(); }
+
+    std::string entryPath(const std::string& stage, uint64_t key, const std::string& ext) const {
+        return (std::filesystem::path(dir) / stage / (hashHex(key) + ext)).string();
+    }
+
+    bool contains(const std::string& stage, uint64_t key, const std::string& ext) const {
+        std::error_code error;
+        return std::filesystem::is_regular_file(entryPath(stage, key, ext), error);
+    }
+
+    // Method to add a finished output as the entry for key, moving it when it already lives in the cache
+    bool store(const std::string& stage, uint64_t key, const std::string& ext, const std::string& sourcePath) {
+        std::string entry = entryPath(stage, key, ext);
+        std::string partial = entry + ".partial";
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(entry).parent_path(), error);
+        if (sourcePath != partial) {
+            std::filesystem::copy_file(sourcePath, partial, std::filesystem::copy_options::overwrite_existing, error);
+        }
+        if (!error) {
+            std::filesystem::rename(partial, entry, error);
+        }
+        if (error) {
+            std::cerr << "Could not store " << stage << " in the stage cache: " << error.message() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Method to get the path a stage writes its output to before store() moves it into place
+    std::string partialPath(const std::string& stage, uint64_t key, const std::string& ext) const {
+        std::string entry = entryPath(stage, key, ext);
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(entry).parent_path(), error);
+        return entry + ".partial";
+    }
+
+    // Method to hash a file's content, memoized by path, size and modification time so unchanged
+    // videos are read once and not on every run
+    uint64_t fileHash(const std::string& path) {
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+        if (error) {
+            return 0;
+        }
+        auto modified = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+        uint64_t identity = Fnv1a64().add(path).add(static_cast<uint64_t>(size)).add(modified).digest();
+
+        std::string memoPath = entryPath("files", identity, ".hash");
+        std::ifstream memo(memoPath);
+        std::string text;
+        if (memo >> text && text.size() == 16) {
+            return std::stoull(text, nullptr, 16);
+        }
+
+        uint64_t hash = hashFileContents(path);
+        std::string partial = partialPath("files", identity, ".hash");
+        std::ofstream(partial) << hashHex(hash) << "\n";
+        store("files", identity, ".hash", partial);
+        return hash;
+    }
+
+private:
+    std::string dir;
+};
+
+// Build identity mixed into every key, any rebuild of the pipeline invalidates the cached outputs
+const char* const STAGE_CACHE_BUILD = __DATE__ " " __TIME__;
+
+// Function to hash the calibration of all cameras
+inline void hashCameraParams(Fnv1a64& hash, const std::vector<CameraData>& cameraParams) {
+    hash.add(cameraParams.size());
+    for (const CameraData& camera : cameraParams) {
+        hash.add(camera.name).add(camera.tvec).add(camera.rvec).add(camera.dist);
+        for (const std::vector<double>& row : camera.K) {
+            hash.add(row);
+        }
+    }
+}
+
+// Function to hash the synthetic scene a run tracks instead of videos
+inline void hashSyntheticScene(Fnv1a64& hash, const SyntheticSceneConfig& scene,
+                               const std::vector<cv::Point3d>& trajectory) {
+    hash.add(scene.frame_size.width).add(scene.frame_size.height).add(scene.fps).add(scene.ball_radius);
+    for (int i = 0; i < 4; ++i) {
+        hash.add(scene.ball_color[i]);
+    }
+    hash.add(scene.noise_sigma).add(scene.noise_variants).add(scene.occluders_num).add(scene.exposure);
+    hash.add(scene.blur_samples).add(scene.background_dir).add(scene.seed);
+    hash.add(trajectory.size());
+    for (const cv::Point3d& point : trajectory) {
+        hash.add(point.x).add(point.y).add(point.z);
+    }
+}
+
+// Function to get the key of the 2D observations: the input frames (inputsHash), the calibration and
+// every option the trackers read. Adaptive runs are never cached, their trackers follow measured costs.
+inline uint64_t observationsCacheKey(uint64_t inputsHash, const std::vector<CameraData>& cameraParams,
+                                     const PipelineConfig& config) {
+    Fnv1a64 hash;
+    hash.add(std::string(STAGE_CACHE_BUILD)).add(std::string("observations")).add(inputsHash);
+    hashCameraParams(hash, cameraParams);
+    hash.add(config.detection_period).add(config.fusion.interframe_mode).add(config.fusion.detection_noise);
+    hash.add(config.fusion.flow_noise).add(config.fusion.correlation_noise);
+    const DetectionParams& detection = config.detection;
+    for (int i = 0; i < 3; ++i) {
+        hash.add(detection.hsv_lower[i]).add(detection.hsv_upper[i]);
+    }
+    hash.add(detection.background_threshold).add(detection.morphology_iterations).add(detection.area_threshold);
+    hash.add(detection.flow_roi_size);
+    return hash.digest();
+}
+
+// Function to get the key of the 3D trajectory: the observations and the options of everything after tracking
+inline uint64_t trajectoryCacheKey(uint64_t observationsKey, const PipelineConfig& config) {
+    Fnv1a64 hash;
+    hash.add(std::string("trajectory")).add(observationsKey).add(config.fps).add(config.use_world_tracker);
+    if (config.use_world_tracker) {
+        const WorldTrackerConfig& tracker = config.world_tracker;
+        hash.add(tracker.acceleration_noise).add(tracker.pixel_noise).add(tracker.initial_position_sigma);
+        hash.add(tracker.initial_velocity_sigma).add(tracker.gate).add(tracker.use_gravity);
+        hash.add(tracker.gravity[0]).add(tracker.gravity[1]).add(tracker.gravity[2]);
+    }
+    hash.add(config.write_smoothed);
+    if (config.write_smoothed) {
+        hash.add(config.smoother.acceleration_noise).add(config.smoother.position_sigma);
+        hash.add(config.smoother.block_size).add(config.smoother.lag);
+    }
+    return hash.digest();
+}
+
+#endif // STAGE_CACHE_H
@@ -0,0 +1,113 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <tbb/parallel_for.h>
+#include "camera.h"
+
+// Time one camera spent in each startup step (ms)
+struct CameraStartupTimes {
+    double open_ms = 0.0;
+    double probe_ms = 0.0;
+    double background_ms = 0.0;
+    double prefetch_ms = 0.0;
+    int prefetched_frames = 0;
+};
+
+// Startup time breakdown, per camera steps run concurrently so their sum exceeds the wall time
+struct StartupReport {
+    double calibration_ms = 0.0; // Calibration bundle mapping or JSON parsing
+    double cameras_wall_ms = 0.0; // Wall time of the concurrent per camera steps
+    double total_ms = 0.0;
+    std::vector<CameraStartupTimes> cameras;
+
+    // Method to print the startup times, synthetic and replayed runs open no videos and only get the total
+    void print() const {
+        std::ios::fmtflags flags = std::cout.flags();
+        std::streamsize precision = std::cout.precision();
+        if (cameras.empty()) {
+            std::cout << "Startup: " << std::fixed << std::setprecision(1) << total_ms << " ms (calibration "
+                      << calibration_ms << " ms)" << std::endl;
+            std::cout.flags(flags);
+            std::cout.precision(precision);
+            return;
+        }
+
+        auto row = [&](const std::string& step, double CameraStartupTimes::*field) {
+            double sum = 0.0, slowest = 0.0;
+            for (const CameraStartupTimes& camera : cameras) {
+                sum += camera.*field;
+                slowest = std::max(slowest, camera.*field);
+            }
+            std::cout << "  " << std::left << std::setw(12) << step << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(10) << sum << " ms total" << std::setw(10) << slowest << " ms slowest camera"
+                      << std::endl;
+        };
+
+        std::cout << "Startup of " << cameras.size() << " cameras: " << std::fixed << std::setprecision(1)
+                  << total_ms << " ms" << std::endl;
+        std::cout << "  calibration " << calibration_ms << " ms" << std::endl;
+        std::cout << "  cameras     " << cameras_wall_ms << " ms wall" << std::endl;
+        row("open", &CameraStartupTimes::open_ms);
+        row("probe", &CameraStartupTimes::probe_ms);
+        row("background", &CameraStartupTimes::background_ms);
+        row("prefetch", &CameraStartupTimes::prefetch_ms);
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+};
+
+// Function to open, probe, load the background of and prefetch frames for every camera concurrently.
+// Container probing, PNG decoding and the first decoder frames dominate startup on large rigs and
+// are independent per camera.
+void initializeCameras(std::vector<Camera>& cameras, const std::string& videoBasePath, const std::string& backgroundPath,
+                       int prefetch_frames, StartupReport& report) {
+    using Clock = std::chrono::steady_clock;
+    auto elapsed = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    report.cameras.assign(cameras.size(), CameraStartupTimes());
+    auto wall_start = Clock::now();
+
+    // One task per camera, the steps are blocking I/O and decoding of very different lengths
+    tbb::parallel_for(size_t(0), cameras.size(), [&](size_t i) {
+        Camera& camera = cameras[i];
+        CameraStartupTimes& times = report.cameras[i];
+
+        auto start = Clock::now();
+        bool opened = camera.openVideo(videoBasePath + camera.name + ".mp4");
+        times.open_ms = elapsed(start);
+
+        if (opened) {
+            start = Clock::now();
+            camera.probeVideo();
+            times.probe_ms = elapsed(start);
+        }
+
+        start = Clock::now();
+        cv::Mat background = cv::imread(backgroundPath + camera.name + "_background.png");
+        if (background.empty()) {
+            std::cerr << "Error: Background image not loaded correctly for camera: " << camera.name << std::endl;
+        } else {
+            camera.setBackground(std::move(background));
+        }
+        times.background_ms = elapsed(start);
+
+        if (opened) {
+            start = Clock::now();
+            times.prefetched_frames = camera.prefetchFrames(prefetch_frames);
+            times.prefetch_ms = elapsed(start);
+        }
+    });
+
+    report.cameras_wall_ms = elapsed(wall_start);
+}
+
+#endif // STARTUP_H
@@ -0,0 +1,343 @@
+#ifndef SYNTHETIC_SCENE_H
+#define SYNTHETIC_SCENE_H
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <tbb/parallel_for.h>
+#include "camera_parameters.h"
+#include "frame_source.h"
+
+// Rendering options of the synthetic scene
+struct SyntheticSceneConfig {
+    cv::Size frame_size = cv::Size(1280, 1024);
+    double fps = 30.0;
+    double ball_radius = 0.05; // Meters
+    cv::Scalar ball_color = cv::Scalar(180, 60, 230); // BGR, inside the detector's pink HSV range
+    double noise_sigma = 3.0; // Gray levels of per pixel sensor noise
+    int noise_variants = 2; // Prebaked noisy backgrounds per camera, frames cycle through them
+    int occluders_num = 2; // Static occluding boxes per camera, drawn in front of the ball
+    double exposure = 0.5; // Fraction of the frame interval the shutter is open, 0 disables motion blur
+    int blur_samples = 5; // Ball positions averaged over the exposure
+    std::string background_dir; // Optional <name>_background.png images, procedural when missing
+    unsigned int seed = 42;
+};
+
+// Function to place cameras_num cameras on a ring around the origin, all looking at target.
+// World y is up as in the ground truth trajectories.
+std::vector<CameraData> makeProceduralRig(int cameras_num, const cv::Size& frame_size, double ring_radius = 6.0,
+                                          double height = 2.0, const cv::Point3d& target = cv::Point3d(0, 0.5, 0),
+                                          double horizontal_fov_deg = 70.0) {
+    double focal = 0.5 * frame_size.width / std::tan(0.5 * horizontal_fov_deg * CV_PI / 180.0);
+    std::vector<CameraData> cameras;
+    for (int i = 0; i < cameras_num; ++i) {
+        double angle = 2.0 * CV_PI * i / cameras_num;
+        cv::Vec3d center(ring_radius * std::cos(angle), height, ring_radius * std::sin(angle));
+
+        // OpenCV camera axes: x right, y down, z forward
+        cv::Vec3d z = cv::normalize(cv::Vec3d(target.x, target.y, target.z) - center);
+        cv::Vec3d x = cv::normalize(z.cross(cv::Vec3d(0, 1, 0)));
+        cv::Vec3d y = z.cross(x);
+        cv::Matx33d R(x[0], x[1], x[2],
+                      y[0], y[1], y[2],
+                      z[0], z[1], z[2]);
+        cv::Vec3d rvec;
+        cv::Rodrigues(R, rvec);
+        cv::Vec3d tvec = -(R * center);
+
+        CameraData camera;
+        camera.name = "camera" + std::to_string(i + 1);
+        camera.rvec = {rvec[0], rvec[1], rvec[2]};
+        camera.tvec = {tvec[0], tvec[1], tvec[2]};
+        camera.K = {{focal, 0.0, (frame_size.width - 1) / 2.0},
+                    {0.0, focal, (frame_size.height - 1) / 2.0},
+                    {0.0, 0.0, 1.0}};
+        cameras.push_back(camera);
+    }
+    return cameras;
+}
+
+// Function to simulate a thrown ball bouncing on the floor y = radius, sampled at fps
+std::vector<cv::Point3d> makeBallisticTrajectory(int frames_num, double fps, const cv::Point3d& start,
+                                                 const cv::Point3d& velocity, double radius = 0.05,
+                                                 double restitution = 0.8, double gravity = 9.81) {
+    std::vector<cv::Point3d> trajectory;
+    cv::Point3d position = start;
+    cv::Point3d speed = velocity;
+    const int substeps = 10;
+    const double dt = 1.0 / (fps * substeps);
+    for (int frame = 0; frame < frames_num; ++frame) {
+        trajectory.push_back(position);
+        for (int step = 0; step < substeps; ++step) {
+            speed.y -= gravity * dt;
+            position += speed * dt;
+            if (position.y < radius && speed.y < 0.0) {
+                position.y = radius;
+                speed.y = -restitution * speed.y;
+            }
+        }
+    }
+    return trajectory;
+}
+
+// Multi camera rendering of a ball following a 3D trajectory. Everything that does not depend on
+// the frame is prepared in the constructor (projections, backgrounds with baked noise, occluders),
+// so a frame costs one background copy plus work on the small window around the ball.
+// render() is const and may run concurrently for different cameras.
+class SyntheticScene {
+public:
+    SyntheticScene(const std::vector<CameraData>& cameras, const std::vector<cv::Point3d>& trajectory,
+                   const SyntheticSceneConfig& config = SyntheticSceneConfig())
+    : config(config), cameras(cameras), trajectory(trajectory), views(cameras.size()) {
+        tbb::parallel_for(size_t(0), cameras.size(), [&](size_t i) {
+            prepareView(i);
+        });
+    }
+
+    size_t camerasNum() const { return cameras.size(); }
+    int framesNum() const { return static_cast<int>(trajectory.size()); }
+    double fps() const { return config.fps; }
+    const std::vector<CameraData>& cameraData() const { return cameras; }
+    const std::vector<cv::Point3d>& groundTruth() const { return trajectory; }
+
+    // Clean background of a camera, with occluders but without noise
+    const cv::Mat& background(size_t camera) const { return views[camera].background; }
+
+    // Method to render a frame of a camera into frame (reusing its buffer), returns whether the ball center
+    // is in front of the camera, inside the image and not behind an occluder
+    bool render(size_t camera, int frame_index, cv::Mat& frame) const {
+        const View& view = views[camera];
+        const cv::Mat& source = view.noisy.empty() ? view.background
+                                                   : view.noisy[frame_index % view.noisy.size()];
+        source.copyTo(frame);
+
+        // Ball positions over the exposure, the last one at the frame time
+        int samples = (config.exposure > 0.0 && frame_index > 0) ? std::max(config.blur_samples, 1) : 1;
+        cv::Point2d centers[16];
+        double radii[16];
+        samples = std::min(samples, 16);
+        cv::Rect2d bounds;
+        int visible_samples = 0;
+        for (int k = 0; k < samples; ++k) {
+            double s = samples == 1 ? 1.0 : 1.0 - config.exposure * (samples - 1 - k) / (samples - 1);
+            cv::Point3d position = frame_index > 0
+                                       ? trajectory[frame_index - 1] + (trajectory[frame_index] - trajectory[frame_index - 1]) * s
+                                       : trajectory[frame_index];
+            if (!project(view, position, centers[visible_samples], radii[visible_samples])) {
+                continue;
+            }
+            cv::Rect2d circle(centers[visible_samples].x - radii[visible_samples] - 1,
+                              centers[visible_samples].y - radii[visible_samples] - 1,
+                              2 * radii[visible_samples] + 2, 2 * radii[visible_samples] + 2);
+            bounds = visible_samples == 0 ? circle : (bounds | circle);
+            visible_samples++;
+        }
+        if (visible_samples == 0) {
+            return false;
+        }
+
+        cv::Rect roi = cv::Rect(cv::Point(cvFloor(bounds.x), cvFloor(bounds.y)),
+                                cv::Point(cvCeil(bounds.x + bounds.width), cvCeil(bounds.y + bounds.height))) &
+                       cv::Rect(0, 0, frame.cols, frame.rows);
+
+        // Coverage of each pixel averaged over the exposure, with a one pixel anti-aliased edge
+        cv::Vec3b color(cv::saturate_cast<uchar>(config.ball_color[0]), cv::saturate_cast<uchar>(config.ball_color[1]),
+                        cv::saturate_cast<uchar>(config.ball_color[2]));
+        for (int y = roi.y; y < roi.y + roi.height; ++y) {
+            cv::Vec3b* row = frame.ptr<cv::Vec3b>(y);
+            for (int x = roi.x; x < roi.x + roi.width; ++x) {
+                double coverage = 0.0;
+                for (int k = 0; k < visible_samples; ++k) {
+                    double d = std::hypot(x - centers[k].x, y - centers[k].y);
+                    coverage += std::clamp(radii[k] + 0.5 - d, 0.0, 1.0);
+                }
+                coverage /= samples;
+                if (coverage > 0.0) {
+                    for (int c = 0; c < 3; ++c) {
+                        row[x][c] = cv::saturate_cast<uchar>(row[x][c] * (1.0 - coverage) + color[c] * coverage);
+                    }
+                }
+            }
+        }
+
+        // Occluders stand in front of the ball, restore their pixels
+        bool occluded = false;
+        cv::Point center = centers[visible_samples - 1];
+        for (const cv::Rect& occluder : view.occluders) {
+            cv::Rect overlap = occluder & roi;
+            if (!overlap.empty()) {
+                source(overlap).copyTo(frame(overlap));
+            }
+            occluded = occluded || occluder.contains(center);
+        }
+        return !occluded && cv::Rect(0, 0, frame.cols, frame.rows).contains(center);
+    }
+
+private:
+    struct View {
+        cv::Matx33d R;
+        cv::Vec3d t;
+        cv::Matx33d K;
+        cv::Mat background;
+        std::vector<cv::Mat> noisy;
+        std::vector<cv::Rect> occluders;
+    };
+
+    // Method to project a ball center, returns false behind the camera
+    bool project(const View& view, const cv::Point3d& position, cv::Point2d& center, double& radius) const {
+        cv::Vec3d camera_point = view.R * cv::Vec3d(position.x, position.y, position.z) + view.t;
+        if (camera_point[2] <= config.ball_radius) {
+            return false;
+        }
+        center = cv::Point2d(view.K(0, 0) * camera_point[0] / camera_point[2] + view.K(0, 2),
+                             view.K(1, 1) * camera_point[1] / camera_point[2] + view.K(1, 2));
+        radius = view.K(0, 0) * config.ball_radius / camera_point[2];
+        return true;
+    }
+
+    void prepareView(size_t index) {
+        const CameraData& camera = cameras[index];
+        View& view = views[index];
+        cv::Rodrigues(cv::Vec3d(camera.rvec[0], camera.rvec[1], camera.rvec[2]), view.R);
+        view.t = cv::Vec3d(camera.tvec[0], camera.tvec[1], camera.tvec[2]);
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                view.K(i, j) = camera.K[i][j];
+            }
+        }
+
+        cv::RNG rng(config.seed + static_cast<unsigned int>(index));
+        cv::Size size = config.frame_size;
+
+        if (!config.background_dir.empty()) {
+            std::string path = (std::filesystem::path(config.background_dir) / (camera.name + "_background.png")).string();
+            cv::Mat image = cv::imread(path);
+            if (!image.empty()) {
+                cv::resize(image, view.background, size);
+            }
+        }
+        if (view.background.empty()) {
+            // Dark, smooth and not pink, so background subtraction and color keying both work on it
+            view.background.create(size, CV_8UC3);
+            for (int y = 0; y < size.height; ++y) {
+                double level = 30.0 + 40.0 * y / size.height;
+                view.background.row(y).setTo(cv::Scalar(level * 0.8, level * 1.2, level * 0.7));
+            }
+            int scale = std::max(size.width, size.height);
+            for (int k = 0; k < 24; ++k) {
+                cv::Point center(rng.uniform(0, size.width), rng.uniform(0, size.height));
+                int radius = rng.uniform(scale / 40, scale / 8);
+                double level = rng.uniform(15.0, 70.0);
+                cv::circle(view.background, center, radius, cv::Scalar(level * 0.9, level * 1.1, level * 0.8), -1);
+            }
+            int kernel = (scale / 100) | 1;
+            cv::GaussianBlur(view.background, view.background, cv::Size(kernel, kernel), 0.0);
+        }
+
+        for (int k = 0; k < config.occluders_num; ++k) {
+            int width = rng.uniform(size.width / 20, size.width / 8);
+            int height = rng.uniform(size.height / 10, size.height / 4);
+            cv::Rect occluder(rng.uniform(0, size.width - width), rng.uniform(0, size.height - height), width, height);
+            double level = rng.uniform(60.0, 110.0);
+            cv::rectangle(view.background, occluder, cv::Scalar(level, level, level), -1);
+            view.occluders.push_back(occluder);
+        }
+
+        if (config.noise_sigma > 0.0) {
+            cv::Mat noise(size, CV_16SC3);
+            for (int k = 0; k < config.noise_variants; ++k) {
+                rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(config.noise_sigma));
+                cv::Mat noisy;
+                cv::add(view.background, noise, noisy, cv::noArray(), CV_8UC3);
+                view.noisy.push_back(noisy);
+            }
+        }
+    }
+
+    SyntheticSceneConfig config;
+    std::vector<CameraData> cameras;
+    std::vector<cv::Point3d> trajectory;
+    std::vector<View> views;
+};
+
+// In memory frames of one camera of a synthetic scene, rendered on demand
+class SyntheticFrameSource : public FrameSource {
+public:
+    SyntheticFrameSource(std::shared_ptr<const SyntheticScene> scene, size_t camera)
+    : scene(std::move(scene)), camera(camera) {}
+
+    bool read(cv::Mat& frame) override {
+        if (next_frame >= scene->framesNum()) {
+            return false;
+        }
+        scene->render(camera, next_frame++, frame);
+        return true;
+    }
+
+    int frameCount() const override { return scene->framesNum(); }
+    double frameRate() const override { return scene->fps(); }
+
+private:
+    std::shared_ptr<const SyntheticScene> scene;
+    size_t camera;
+    int next_frame = 0;
+};
+
+// Function to write a scene in the layout the pipeline reads: calibration/cameras.json,
+// videos/<name>.mp4, videos/background/<name>_background.png and csv_files/ball_pos_gt.csv
+bool writeSyntheticScene(const SyntheticScene& scene, const std::string& outputDir) {
+    std::filesystem::path root(outputDir);
+    std::error_code error;
+    for (const char* dir : {"calibration", "videos/background", "csv_files"}) {
+        std::filesystem::create_directories(root / dir, error);
+        if (error) {
+            std::cerr << "Could not create directory: " << (root / dir).string() << std::endl;
+            return false;
+        }
+    }
+
+    if (!saveCameraParamsToJson(scene.cameraData(), (root / "calibration" / "cameras.json").string())) {
+        return false;
+    }
+
+    std::ofstream groundTruth((root / "csv_files" / "ball_pos_gt.csv").string());
+    for (const cv::Point3d& point : scene.groundTruth()) {
+        groundTruth << point.x << "," << point.y << "," << point.z << "\n";
+    }
+
+    std::vector<char> written(scene.camerasNum(), 0);
+    tbb::parallel_for(size_t(0), scene.camerasNum(), [&](size_t i) {
+        const std::string& name = scene.cameraData()[i].name;
+        cv::imwrite((root / "videos" / "background" / (name + "_background.png")).string(), scene.background(i));
+
+        cv::VideoWriter writer((root / "videos" / (name + ".mp4")).string(), cv::VideoWriter::fourcc('m', 'p', '4', 'v'),
+                               scene.fps(), scene.background(i).size());
+        if (!writer.isOpened()) {
+            return;
+        }
+        cv::Mat frame;
+        for (int frame_index = 0; frame_index < scene.framesNum(); ++frame_index) {
+            scene.render(i, frame_index, frame);
+            writer.write(frame);
+        }
+        written[i] = 1;
+    });
+
+    bool success = true;
+    for (size_t i = 0; i < scene.camerasNum(); ++i) {
+        if (!written[i]) {
+            std::cerr << "Could not write video of camera: " << scene.cameraData()[i].name << std::endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+#endif // SYNTHETIC_SCENE_H
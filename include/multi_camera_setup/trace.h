@@ -0,0 +1,146 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Timeline tracing of the pipeline stages in the Chrome trace event format, which chrome://tracing
+// and ui.perfetto.dev open directly. Compiled in with MCS_ENABLE_TRACING and switched on at run time
+// with --trace; until then a build without metrics pays one branch per stage scope.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One stage execution, written as a complete ("X") event with its begin and end time
+struct TraceEvent {
+    int64_t begin_ns;
+    int64_t end_ns;
+    int32_t frame;
+    int16_t camera;
+    int16_t stage;
+};
+
+// Events of one thread. Only the owning thread writes, the count is published with release
+// stores so the exporter sees complete events. Full buffers wrap and keep the newest events.
+struct ThreadTrace {
+    explicit ThreadTrace(size_t capacity, int thread_id) : events(capacity), thread_id(thread_id) {}
+
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> written{0};
+    int thread_id;
+};
+
+class PipelineTracer {
+public:
+    static PipelineTracer& instance() {
+        static PipelineTracer tracer;
+        return tracer;
+    }
+
+    // Method to start recording, events_per_thread (rounded up to a power of two) bounds the memory of each thread
+    void enable(size_t events_per_thread) {
+        capacity = 1;
+        while (capacity < events_per_thread) {
+            capacity <<= 1;
+        }
+        origin = std::chrono::steady_clock::now();
+        enabled.store(true, std::memory_order_release);
+    }
+
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Frame index attached to the events that follow, set by the frame loop before its parallel_for
+    void setFrame(int frame_index) { frame.store(frame_index, std::memory_order_relaxed); }
+
+    // Frame index attached to the events the calling thread records from here on, over the one of the
+    // frame loop. For threads that run ahead on frames of their own, like the camera threads of quorum fusion.
+    void setThreadFrame(int frame_index) { threadFrame() = frame_index; }
+
+    int64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    void record(int stage, int camera, int64_t begin_ns, int64_t end_ns) {
+        thread_local ThreadTrace* local = nullptr;
+        if (local == nullptr) {
+            local = registerThread();
+        }
+        int event_frame = threadFrame();
+        if (event_frame < 0) {
+            event_frame = frame.load(std::memory_order_relaxed);
+        }
+        uint64_t index = local->written.load(std::memory_order_relaxed);
+        local->events[index & (local->events.size() - 1)] = {begin_ns, end_ns, event_frame,
+                                                       static_cast<int16_t>(camera), static_cast<int16_t>(stage)};
+        local->written.store(index + 1, std::memory_order_release);
+    }
+
+    // Method to write the recorded events as Chrome trace JSON, call once the pipeline is idle
+    bool write(const std::string& path, const char* (*stage_name)(int)) const {
+        std::ofstream file(path);
+        if (!file) {
+            std::cerr << "Could not write trace: " << path << std::endl;
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        file << "{\"ph\": \"M\", \"pid\": 1, \"name\": \"process_name\", \"args\": {\"name\": \"multi_camera_setup\"}}";
+
+        uint64_t events_num = 0, overwritten = 0;
+        for (const auto& thread : threads) {
+            file << ",\n{\"ph\": \"M\", \"pid\": 1, \"tid\": " << thread->thread_id
+                 << ", \"name\": \"thread_name\", \"args\": {\"name\": \"worker " << thread->thread_id << "\"}}";
+
+            uint64_t written = thread->written.load(std::memory_order_acquire);
+            uint64_t size = thread->events.size();
+            uint64_t first = written > size ? written - size : 0;
+            overwritten += first;
+            for (uint64_t i = first; i < written; ++i) {
+                const TraceEvent& event = thread->events[i % size];
+                char line[256];
+                std::snprintf(line, sizeof(line),
+                              ",\n{\"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"name\": \"%s\", \"ts\": %.3f, \"dur\": %.3f, "
+                              "\"args\": {\"camera\": %d, \"frame\": %d}}",
+                              thread->thread_id, stage_name(event.stage), event.begin_ns * 1e-3,
+                              (event.end_ns - event.begin_ns) * 1e-3, event.camera, event.frame);
+                file << line;
+                events_num++;
+            }
+        }
+        file << "\n]}\n";
+        std::cout << "Wrote " << events_num << " trace events to " << path;
+        if (overwritten > 0) {
+            std::cout << " (" << overwritten << " older events overwritten)";
+        }
+        std::cout << std::endl;
+        return static_cast<bool>(file);
+    }
+
+private:
+    PipelineTracer() = default;
+
+    static int& threadFrame() {
+        thread_local int frame_index = -1; // Follow the frame loop
+        return frame_index;
+    }
+
+    ThreadTrace* registerThread() {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.emplace_back(new ThreadTrace(capacity, static_cast<int>(threads.size()) + 1));
+        return threads.back().get();
+    }
+
+    std::atomic<bool> enabled{false};
+    std::atomic<int> frame{0};
+    size_t capacity = 1;
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    mutable std::mutex mutex; // Guards the thread list only, never held while recording
+    std::vector<std::unique_ptr<ThreadTrace>> threads;
+};
+
+#endif // TRACE_H
@@ -1,60 +1,59 @@
+#ifndef TRACKING_H
+#define TRACKING_H
+
 #include <opencv2/opencv.hpp>
 #include <iostream>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 #include "camera.h"
 #include "utils.h"
+#include "world_tracker.h"
+#include "pipeline_config.h"
+#include "metrics.h"
+#include "detection_params.h"
 
 using namespace cv;
 using namespace std;
 
-void calculateCurrentPosition(cv::Mat &mask, cv::Mat &frame, Camera &camera)
+void calculateCurrentPosition(BitMaskWorkspace &masks, Camera &camera, float areaThreshold = 50.0f)
 {
-    float areaThreshold = 50.0f;
-    vector<Point> contour = findContoursInMask(mask, areaThreshold);
-
-    if (!contour.empty())
+    MaskBlob blob;
+    if (findLargestMaskBlob(masks, areaThreshold, blob))
     {
         {
-            getPositionFromContour(frame, contour, camera.current_tracker_position, camera.previous_tracker_position);
-            camera.is_detection_valid = true;
-            //camera.kalman_fitler.correct(camera.current_tracker_position);
-            //camera.current_tracker_position = camera.kalman_fitler.predict();
+            getPositionFromContour(masks.points, camera.state->current_tracker_position, camera.state->tracker_radius);
+            camera.state->blob_area = static_cast<float>(blob.area);
+            camera.state->is_detection_valid = true;
+            //camera.state->kalman_fitler.correct(camera.state->current_tracker_position);
+            //camera.state->current_tracker_position = camera.state->kalman_fitler.predict();
         }
         
     }
     else
     {
-        //cout << "previous tracker position: " << camera.previous_tracker_position << endl;
-        camera.is_detection_valid = false;
-        //camera.kalman_fitler.correct(camera.current_tracker_position);
-        //camera.current_tracker_position = camera.kalman_fitler.predict();
+        //cout << "previous tracker position: " << camera.state->previous_tracker_position << endl;
+        camera.state->is_detection_valid = false;
+        camera.state->tracker_radius = 0.0f;
+        camera.state->blob_area = 0.0f;
+        //camera.state->kalman_fitler.correct(camera.state->current_tracker_position);
+        //camera.state->current_tracker_position = camera.state->kalman_fitler.predict();
 
-        camera.current_tracker_position = camera.previous_tracker_position + camera.tracker_speed;
+        camera.state->current_tracker_position = camera.state->previous_tracker_position + camera.state->tracker_speed;
     }
 }
 
 void calculateTrackerSpeed(Camera &camera, cv::Mat &frame)
 {
-    camera.tracker_speed = camera.current_tracker_position - camera.previous_tracker_position;
-    visualizeSpeed(camera.previous_tracker_position, camera.current_tracker_position, frame);
+    camera.state->tracker_speed = camera.state->current_tracker_position - camera.state->previous_tracker_position;
+    visualizeSpeed(camera.state->previous_tracker_position, camera.state->current_tracker_position, frame);
 }
 
-void trackerByDetection(Camera &camera)
+// Function to pack the detection mask of a frame (or a band of rows of it) into rows [first_row, first_row + frame.rows)
+// of mask: the HSV color key AND the background subtraction, one bit per pixel
+void packDetectionMask(const cv::Mat &frame, const cv::Mat &background, const DetectionParams &params, BitMask &mask,
+                       int first_row)
 {
-    
-    Mat &frame = camera.current_frame;
-    Mat &background = camera.background;
-
-    if (frame.empty() || background.empty())
-    {
-        cerr << "Error: Frame or background is empty." << endl;
-        return;
-    }
-
-    // HSV range for the pink ball
-    Scalar lower_pink(130, 50, 50);
-    Scalar upper_pink(180, 255, 255);
-
-    Mat mask, diff, foregroundMask, hsvFrame;
+    Mat diff, foregroundMask, hsvFrame, colorMask;
 
     // Convert frame to HSV
     cvtColor(frame, hsvFrame, COLOR_BGR2HSV);
@@ -62,63 +61,282 @@ void trackerByDetection(Camera &camera)
     // Background subtraction
     absdiff(frame, background, diff);
     cvtColor(diff, diff, COLOR_BGR2GRAY);
-    threshold(diff, foregroundMask, 50, 255, THRESH_BINARY);
-
-   
+    threshold(diff, foregroundMask, params.background_threshold, 255, THRESH_BINARY);
 
     // Color keying in HSV
-    inRange(hsvFrame, lower_pink, upper_pink, mask);
+    inRange(hsvFrame, params.hsv_lower, params.hsv_upper, colorMask);
+
+    // Combine the masks into one bit per pixel
+    mask.packAndRows(colorMask, foregroundMask, first_row);
+}
+
+// Function to build the cleaned detection mask in row tiles run as nested TBB tasks, so idle cores steal
+// tiles of the cameras still detecting. Each tile also computes a halo of 2 * morphology_iterations rows on
+// both sides, the rows the dilate/erode pairs read across its edges, so the result is the untiled mask.
+void buildDetectionMaskTiled(const cv::Mat &frame, const cv::Mat &background, const DetectionParams &params,
+                             BitMaskWorkspace &masks)
+{
+    const int tile_rows = params.tile_rows;
+    const int tiles = (frame.rows + tile_rows - 1) / tile_rows;
+    const int halo = 2 * params.morphology_iterations;
+    masks.mask.create(frame.rows, frame.cols);
+    if (static_cast<int>(masks.tiles.size()) < tiles)
+    {
+        masks.tiles.resize(tiles);
+    }
+
+    tbb::parallel_for(tbb::blocked_range<int>(0, tiles, 1), [&](const tbb::blocked_range<int> &range) {
+        for (int t = range.begin(); t != range.end(); ++t)
+        {
+            int first = t * tile_rows;
+            int last = std::min(first + tile_rows, frame.rows);
+            int halo_first = std::max(first - halo, 0);
+            int halo_last = std::min(last + halo, frame.rows);
+
+            BitMaskTile &tile = masks.tiles[t];
+            tile.mask.create(halo_last - halo_first, frame.cols);
+            packDetectionMask(frame.rowRange(halo_first, halo_last), background.rowRange(halo_first, halo_last),
+                              params, tile.mask, 0);
+            closeBitMask(tile.mask, tile.scratch, params.morphology_iterations);
+            masks.mask.copyRows(tile.mask, first - halo_first, first, last - first);
+        }
+    });
+}
+
+void trackerByDetection(Camera &camera, const cv::Rect &roi, const DetectionParams &params = DetectionParams())
+{
+    MCS_STAGE_SCOPE(Stage::Detection, camera.index);
+    if (camera.current_frame.empty() || camera.background.empty())
+    {
+        cerr << "Error: Frame or background is empty." << endl;
+        return;
+    }
 
-    // Combine the masks
-    bitwise_and(mask, foregroundMask, mask);
+    Mat frame = camera.current_frame(roi);
+    Mat background = camera.background(roi);
 
-    // Apply some preprocessing (e.g., dilate and erode to clean up the mask)
-    dilate(mask, mask, Mat(), Point(-1, -1), 2);
-    erode(mask, mask, Mat(), Point(-1, -1), 2);
+    BitMaskWorkspace &masks = camera.detection_mask;
+    {
+        MCS_STAGE_SCOPE(Stage::Mask, camera.index);
 
-    
+        // Frames of at least two tiles are split, windowed detections are too small to gain from it
+        if (params.tile_rows > 0 && frame.rows >= 2 * params.tile_rows)
+        {
+            buildDetectionMaskTiled(frame, background, params, masks);
+        }
+        else
+        {
+            masks.mask.create(frame.rows, frame.cols);
+            packDetectionMask(frame, background, params, masks.mask, 0);
 
-    if (mask.empty())
+            // Clean up the mask like dilate then erode with a 3x3 square, on 64 pixels per word
+            closeBitMask(masks.mask, masks.scratch, params.morphology_iterations);
+        }
+    }
+
+    if (masks.mask.empty())
     {
         cerr << "Error: Mask is empty." << endl;
         return;
     }
 
-    calculateCurrentPosition(mask, frame, camera);
+    {
+        MCS_STAGE_SCOPE(Stage::Contours, camera.index);
+        calculateCurrentPosition(masks, camera, params.area_threshold);
+    }
+    if (camera.state->is_detection_valid)
+    {
+        camera.state->current_tracker_position += cv::Point2f(roi.tl());
+    }
+}
 
-    calculateTrackerSpeed(camera, frame);
+void trackerByDetection(Camera &camera, const DetectionParams &params = DetectionParams())
+{
+    trackerByDetection(camera, cv::Rect(0, 0, camera.current_frame.cols, camera.current_frame.rows), params);
+}
 
-    camera.previous_tracker_position = camera.current_tracker_position;
+// Function to size the cameras' optical flow crops for the detection parameters, before tracking starts
+void configureFlowTrackers(std::vector<Camera> &cameras, const DetectionParams &params)
+{
+    OpticalFlowConfig flowConfig;
+    flowConfig.roi_size = params.flow_roi_size;
+    for (Camera &camera : cameras)
+    {
+        camera.flow_tracker = OpticalFlowTracker(flowConfig);
+    }
 }
 
+// Function to get the detection window around the predicted position, grown with speed and uncertainty
+cv::Rect getDetectionRoi(const Camera &camera)
+{
+    cv::Point2f predicted = camera.state->previous_tracker_position + camera.state->tracker_speed;
+    float side = 96.0f + 4.0f * static_cast<float>(cv::norm(camera.state->tracker_speed)) +
+                 6.0f * std::sqrt(camera.state->kalman_fitler.positionVariance());
+    int half = cvRound(std::min(side, 512.0f) / 2.0f);
+    cv::Rect roi(cvRound(predicted.x) - half, cvRound(predicted.y) - half, 2 * half, 2 * half);
+    return roi & cv::Rect(0, 0, camera.current_frame.cols, camera.current_frame.rows);
+}
 
-void trackBallInFrame(Camera &camera, int frame_index, int cameras_num)
+// Function to pick the tracker of a camera with the fixed schedule: detection in the camera selected by
+// checkDetectionActive or in a camera without a tracker reference, interframe_mode everywhere else.
+TrackerMode selectRoundRobinMode(Camera &camera, int frame_index, int detection_period,
+                                 TrackerMode interframe_mode = TrackerMode::OpticalFlow)
 {
+    camera.state->is_detection_active = checkDetectionActive(frame_index, detection_period, camera);
+    return (camera.state->is_detection_active || !camera.canTrackWith(interframe_mode)) ? TrackerMode::FullDetection
+                                                                                 : interframe_mode;
+}
 
-    //active detection flag for each camera based on the frame index and camera index for future use.
-    camera.is_detection_active = checkDetectionActive(frame_index, cameras_num, camera);
 
-    trackerByDetection(camera);
+// Function to track the ball in one camera with the given tracker, fused by the camera's Kalman filter.
+// Optical flow runs whenever a flow reference exists, detection (full or windowed) when the mode asks
+// for it, and frames where both are available fuse both measurements. With the correlation filter as
+// the tracker between detections the flow tracker is idle and the filter is trained on detections and
+// on the frames it tracks itself. A camera whose measurements all fail loses its track and needs a full detection to start again.
+void trackBallInFrame(Camera &camera, TrackerMode mode, const TrackingFusionConfig &fusion,
+                      const DetectionParams &detection = DetectionParams())
+{
+    camera.state->tracker_mode = mode;
+    camera.state->tracker_radius = 0.0f;
+    camera.state->blob_area = 0.0f;
 
-        //Was not able to get good results from the optical flow and kalman filter.
-        //TODO learn both to complete the task.
+    bool use_correlation = fusion.interframe_mode == TrackerMode::CorrelationFilter;
+    cv::Point2f predicted_position = camera.state->previous_tracker_position + camera.state->tracker_speed;
 
-        /*
-        First frame: detection in all cameras.
-        2nd frame: detection in camera 1, optical flow all cameras.
-        3nd frame: detection in camera 2, optical flow all cameras.
-        4nd frame: detection in camera 3, optical flow all cameras.
-        5nd frame: detection in camera 4, optical flow all cameras.
-        …
-        N+1 frame: detection in camera Modulo(N,4), optical flow all cameras.
-        When a detection and kalman is performed you need to combine the two using data fusion.
-            Data Fusion:
-        ●	Use or implement a filter (e.g. Kalman) to combine&integrate the data from the 
-        optical flow and the detection system, primarily for frames where both data types are available.
+    // Optical flow and the correlation filter run on the clean frame, before anything is drawn on it
+    bool has_previous = camera.state->is_tracking && camera.flow_tracker.hasPrevious();
 
-        */
-   
+    bool flow_valid = false;
+    cv::Point2f flow_position;
+    if (has_previous && mode != TrackerMode::PredictOnly)
+    {
+        MCS_STAGE_SCOPE(Stage::Tracking, camera.index);
+        flow_valid = camera.flow_tracker.track(camera.current_frame, camera.state->previous_tracker_position,
+                                               predicted_position, flow_position);
+    }
 
+    bool correlation_valid = false;
+    cv::Point2f correlation_position;
+    if (mode == TrackerMode::CorrelationFilter && camera.canTrackWith(mode))
+    {
+        MCS_STAGE_SCOPE(Stage::Tracking, camera.index);
+        correlation_valid = camera.correlation_tracker.update(camera.current_frame, predicted_position,
+                                                              correlation_position);
+    }
+
+    bool detection_valid = false;
+    if (mode == TrackerMode::FullDetection)
+    {
+        trackerByDetection(camera, detection);
+        detection_valid = camera.state->is_detection_valid;
+    }
+    else if (mode == TrackerMode::RoiDetection)
+    {
+        cv::Rect roi = getDetectionRoi(camera);
+        if (!roi.empty())
+        {
+            trackerByDetection(camera, roi, detection);
+            detection_valid = camera.state->is_detection_valid;
+        }
+    }
+
+    if (!camera.state->is_tracking)
+    {
+        // (Re)start the filter on the first detection
+        if (detection_valid)
+        {
+            camera.state->kalman_fitler.reset(camera.state->current_tracker_position);
+            camera.state->is_tracking = true;
+            if (use_correlation)
+            {
+                camera.correlation_tracker.init(camera.current_frame, camera.state->current_tracker_position);
+            }
+        }
+    }
+    else
+    {
+        cv::Point2f detection_position = camera.state->current_tracker_position;
+        camera.state->current_tracker_position = camera.state->kalman_fitler.predict();
+        if (flow_valid)
+        {
+            camera.state->current_tracker_position = camera.state->kalman_fitler.correct(flow_position, fusion.flow_noise);
+        }
+        if (correlation_valid)
+        {
+            camera.state->current_tracker_position = camera.state->kalman_fitler.correct(correlation_position,
+                                                                           fusion.correlation_noise);
+        }
+        if (detection_valid)
+        {
+            camera.state->current_tracker_position = camera.state->kalman_fitler.correct(detection_position, fusion.detection_noise);
+        }
+        // Keep following the flow between detections, but drop the track once nothing supports it
+        camera.state->is_tracking = flow_valid || correlation_valid || detection_valid || mode == TrackerMode::PredictOnly;
+
+        // The filter trained itself in update(), detections keep it fresh in the other frames
+        if (use_correlation && camera.state->is_tracking && detection_valid && mode != TrackerMode::CorrelationFilter)
+        {
+            camera.correlation_tracker.train(camera.current_frame, camera.state->current_tracker_position);
+        }
+    }
+
+    camera.state->is_detection_valid = detection_valid || flow_valid || correlation_valid;
+    camera.state->measurement_flags = static_cast<uint8_t>((detection_valid ? MeasuredByDetection : 0) |
+                                                           (flow_valid ? MeasuredByFlow : 0) |
+                                                           (correlation_valid ? MeasuredByCorrelation : 0));
+    camera.state->frames_since_detection = detection_valid ? 0 : camera.state->frames_since_detection + 1;
+
+    // Keep a flow reference around the fused position for the next frame, a skipped frame breaks it
+    if (!camera.state->is_tracking || mode == TrackerMode::PredictOnly || use_correlation)
+    {
+        camera.flow_tracker.invalidate();
+    }
+    else if (!camera.flow_tracker.covers(camera.state->current_tracker_position))
+    {
+        camera.flow_tracker.prepare(camera.current_frame, camera.state->current_tracker_position);
+    }
+
+    if (detection_valid)
+    {
+        visualizeDetection(camera.current_frame, camera.state->current_tracker_position, camera.state->tracker_radius);
+    }
+    calculateTrackerSpeed(camera, camera.current_frame);
+
+    camera.state->previous_tracker_position = camera.state->current_tracker_position;
 }
 
+// Function to fuse the valid observations of a frame into the world tracker and return its position.
+// A DLT over the cameras that see the ball is only needed once, to initialize the filter.
+cv::Point3d fuseCameraObservations(const CameraGeometryBlock& geometry, WorldTracker& tracker, double timestamp)
+{
+    if (!tracker.isInitialized())
+    {
+        std::vector<cv::Mat> validProjections;
+        std::vector<cv::Point2d> validPoints;
+        for (size_t i = 0; i < geometry.size(); ++i)
+        {
+            if (geometry.valid[i])
+            {
+                validProjections.push_back(geometry.projection_matrices[i]);
+                validPoints.push_back(geometry.image_points[i]);
+            }
+        }
+        if (validPoints.size() >= 2)
+        {
+            tracker.initialize(triangulatePoint(validProjections, validPoints), timestamp);
+        }
+        return tracker.position();
+    }
+
+    tracker.predict(timestamp);
+    for (size_t i = 0; i < geometry.size(); ++i)
+    {
+        if (geometry.valid[i])
+        {
+            tracker.update(geometry.projections[i], geometry.image_points[i]);
+        }
+    }
+    return tracker.position();
+}
 
+#endif // TRACKING_H
@@ -0,0 +1,271 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <tbb/parallel_for.h>
+#include "camera_rig.h"
+#include "detection_params.h"
+#include "evaluator.h"
+#include "pipeline_config.h"
+#include "tracking.h"
+
+// Score of one detection configuration
+struct DetectionTuningResult {
+    DetectionParams params;
+    double ms_per_frame = 0.0; // Tracking time of all cameras per frame, on one core
+    TrajectoryErrorSummary error;
+    bool on_front = false;
+};
+
+// Decoded frames of all cameras, read once and shared read-only by every evaluation
+struct TuningFrames {
+    std::vector<std::vector<cv::Mat>> frames; // [camera][frame]
+    std::vector<cv::Mat> backgrounds;
+
+    size_t framesNum() const { return frames.empty() ? 0 : frames[0].size(); }
+};
+
+// Function to decode up to frames_num frames of every camera, in parallel across cameras
+TuningFrames loadTuningFrames(std::vector<Camera>& cameras, int frames_num) {
+    TuningFrames cache;
+    cache.frames.resize(cameras.size());
+    cache.backgrounds.resize(cameras.size());
+    tbb::parallel_for(size_t(0), cameras.size(), [&](size_t i) {
+        cache.backgrounds[i] = cameras[i].background;
+        for (int f = 0; f < frames_num && cameras[i].readNextFrame(); ++f) {
+            cache.frames[i].push_back(cameras[i].current_frame.clone());
+        }
+    });
+    // Cameras must agree on the frame count, a short video bounds them all
+    size_t frames = cache.frames.empty() ? 0 : cache.frames[0].size();
+    for (const auto& camera : cache.frames) {
+        frames = std::min(frames, camera.size());
+    }
+    for (auto& camera : cache.frames) {
+        camera.resize(frames);
+    }
+    return cache;
+}
+
+// Function to build the default grid around the hand tuned constants
+std::vector<DetectionParams> makeDetectionGrid() {
+    std::vector<DetectionParams> grid;
+    for (double hue : {120.0, 130.0, 140.0}) {
+        for (double background_threshold : {30.0, 50.0, 70.0}) {
+            for (int iterations : {1, 2}) {
+                for (float area : {20.0f, 50.0f, 100.0f}) {
+                    for (int roi : {96, 128}) {
+                        DetectionParams params;
+                        params.hsv_lower[0] = hue;
+                        params.background_threshold = background_threshold;
+                        params.morphology_iterations = iterations;
+                        params.area_threshold = area;
+                        params.flow_roi_size = roi;
+                        grid.push_back(params);
+                    }
+                }
+            }
+        }
+    }
+    return grid;
+}
+
+// Function to draw random configurations from the ranges the grid spans, plus saturation and value bounds
+std::vector<DetectionParams> sampleDetectionParams(int samples, unsigned int seed) {
+    std::mt19937 rng(seed);
+    auto uniform = [&](double low, double high) { return std::uniform_real_distribution<double>(low, high)(rng); };
+    auto integer = [&](int low, int high) { return std::uniform_int_distribution<int>(low, high)(rng); };
+
+    std::vector<DetectionParams> params(samples);
+    for (DetectionParams& p : params) {
+        p.hsv_lower = cv::Scalar(uniform(110.0, 150.0), uniform(20.0, 100.0), uniform(20.0, 100.0));
+        p.background_threshold = uniform(20.0, 90.0);
+        p.morphology_iterations = integer(0, 3);
+        p.area_threshold = static_cast<float>(uniform(10.0, 150.0));
+        p.flow_roi_size = 16 * integer(4, 10);
+    }
+    return params;
+}
+
+// Function to track the cached frames with one configuration and score it against ground truth.
+// Runs on the calling thread only so configurations can be evaluated side by side.
+DetectionTuningResult evaluateDetectionParams(const DetectionParams& params, const std::vector<CameraData>& cameraParams,
+                                              const std::vector<cv::Mat>& projectionMatrices, const TuningFrames& cache,
+                                              const std::vector<cv::Point3d>& groundTruth, const PipelineConfig& config) {
+    CameraRig rig(cameraParams);
+    std::vector<Camera>& cameras = rig.cameras;
+    rig.geometry.setProjectionMatrices(projectionMatrices);
+    configureFlowTrackers(cameras, params);
+    for (size_t i = 0; i < cameras.size(); ++i) {
+        cameras[i].setBackground(cache.backgrounds[i]);
+    }
+
+    int detection_period = config.detection_period > 0 ? config.detection_period : static_cast<int>(cameras.size());
+    WorldTracker worldTracker(config.world_tracker);
+    TriangulationQuality quality;
+    TrajectoryEvaluator evaluator;
+    double tracking_ms = 0.0;
+    size_t frames = std::min(cache.framesNum(), groundTruth.size());
+
+    for (size_t f = 0; f < frames; ++f) {
+        for (size_t i = 0; i < cameras.size(); ++i) {
+            Camera& camera = cameras[i];
+            cache.frames[i][f].copyTo(camera.current_frame); // Tracking draws on the frame
+
+            auto start = std::chrono::steady_clock::now();
+            TrackerMode mode = selectRoundRobinMode(camera, static_cast<int>(f), detection_period,
+                                                    config.fusion.interframe_mode);
+            trackBallInFrame(camera, mode, config.fusion, params);
+            camera.state->undistorted_position = camera.getUndistortedTrackerPosition();
+            tracking_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        rig.geometry.gather(rig.states);
+        cv::Point3d point3D = config.use_world_tracker
+                                  ? fuseCameraObservations(rig.geometry, worldTracker, f / config.fps)
+                                  : triangulatePoint(rig.geometry, &quality);
+        evaluator.add(point3D, groundTruth[f]);
+    }
+
+    DetectionTuningResult result;
+    result.params = params;
+    result.ms_per_frame = frames > 0 ? tracking_ms / frames : 0.0;
+    result.error = evaluator.summary();
+    return result;
+}
+
+// Function to flag the configurations no other one beats in both tracking time and RMSE
+void markParetoFront(std::vector<DetectionTuningResult>& results, double max_missing) {
+    std::vector<DetectionTuningResult*> eligible;
+    for (DetectionTuningResult& result : results) {
+        size_t frames = result.error.samples + result.error.missing;
+        result.on_front = false;
+        if (result.error.samples > 0 && result.error.missing <= max_missing * frames) {
+            eligible.push_back(&result);
+        }
+    }
+    std::sort(eligible.begin(), eligible.end(), [](const DetectionTuningResult* a, const DetectionTuningResult* b) {
+        return a->ms_per_frame < b->ms_per_frame ||
+               (a->ms_per_frame == b->ms_per_frame && a->error.rmse_mm < b->error.rmse_mm);
+    });
+    double best_rmse = std::numeric_limits<double>::infinity();
+    for (DetectionTuningResult* result : eligible) {
+        if (result->error.rmse_mm < best_rmse) {
+            result->on_front = true;
+            best_rmse = result->error.rmse_mm;
+        }
+    }
+}
+
+// Function to write every evaluated configuration as CSV
+bool writeTuningResultsCsv(const std::vector<DetectionTuningResult>& results, const std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Could not write tuning results: " << path << std::endl;
+        return false;
+    }
+    file << "h_low,s_low,v_low,h_high,s_high,v_high,background_threshold,morphology_iterations,area_threshold,"
+            "flow_roi_size,ms_per_frame,rmse_mm,p95_mm,missing,on_front\n";
+    for (const DetectionTuningResult& result : results) {
+        const DetectionParams& p = result.params;
+        file << p.hsv_lower[0] << "," << p.hsv_lower[1] << "," << p.hsv_lower[2] << "," << p.hsv_upper[0] << ","
+             << p.hsv_upper[1] << "," << p.hsv_upper[2] << "," << p.background_threshold << ","
+             << p.morphology_iterations << "," << p.area_threshold << "," << p.flow_roi_size << ","
+             << result.ms_per_frame << "," << result.error.rmse_mm << "," << result.error.p95_mm << ","
+             << result.error.missing << "," << (result.on_front ? 1 : 0) << "\n";
+    }
+    return true;
+}
+
+// Function to write the Pareto front, fastest first, as a JSON array of {params, scores}
+bool writeParetoFrontJson(const std::vector<DetectionTuningResult>& front, const std::string& path) {
+    nlohmann::json entries = nlohmann::json::array();
+    for (const DetectionTuningResult& result : front) {
+        entries.push_back({{"params", detectionParamsToJson(result.params)},
+                           {"ms_per_frame", result.ms_per_frame},
+                           {"rmse_mm", result.error.rmse_mm},
+                           {"p95_mm", result.error.p95_mm},
+                           {"missing", result.error.missing}});
+    }
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Could not write Pareto front: " << path << std::endl;
+        return false;
+    }
+    file << entries.dump(2) << "\n";
+    return true;
+}
+
+// Function to evaluate the grid (or random samples) on all cores and report the speed/accuracy Pareto front
+std::vector<DetectionTuningResult> runDetectionTuner(const DetectionTunerConfig& tuner, const PipelineConfig& config,
+                                                     const std::vector<CameraData>& cameraParams,
+                                                     const std::vector<cv::Mat>& projectionMatrices,
+                                                     const TuningFrames& cache,
+                                                     const std::vector<cv::Point3d>& groundTruth) {
+    std::vector<DetectionParams> candidates =
+        tuner.samples > 0 ? sampleDetectionParams(tuner.samples, tuner.seed) : makeDetectionGrid();
+    candidates.insert(candidates.begin(), config.detection); // The current configuration as the reference
+    for (DetectionParams& candidate : candidates) {
+        candidate.tile_rows = 0; // Timed on one core, tiles would spread a configuration over several
+    }
+    std::cout << "Tuning " << candidates.size() << " detection configurations on " << cache.framesNum()
+              << " frames of " << cache.frames.size() << " cameras" << std::endl;
+
+    // One configuration per core, OpenCV's own threads would only contend with them and blur the timings
+    int opencv_threads = cv::getNumThreads();
+    cv::setNumThreads(1);
+    std::vector<DetectionTuningResult> results(candidates.size());
+    auto start = std::chrono::steady_clock::now();
+    tbb::parallel_for(size_t(0), candidates.size(), size_t(1), [&](size_t i) {
+        results[i] = evaluateDetectionParams(candidates[i], cameraParams, projectionMatrices, cache, groundTruth, config);
+    });
+    cv::setNumThreads(opencv_threads);
+    std::cout << "Evaluated in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+              << " s" << std::endl;
+
+    markParetoFront(results, tuner.max_missing);
+    std::vector<DetectionTuningResult> front;
+    for (const DetectionTuningResult& result : results) {
+        if (result.on_front) {
+            front.push_back(result);
+        }
+    }
+    std::sort(front.begin(), front.end(), [](const DetectionTuningResult& a, const DetectionTuningResult& b) {
+        return a.ms_per_frame < b.ms_per_frame;
+    });
+
+    const DetectionTuningResult& reference = results[0];
+    std::cout << std::fixed << std::setprecision(2) << "Current: " << reference.ms_per_frame << " ms/frame, RMSE "
+              << reference.error.rmse_mm << " mm, " << reference.error.missing << " missing" << std::endl;
+    std::cout << "Pareto front (" << front.size() << "):" << std::endl;
+    std::cout << "  index  ms/frame   RMSE mm   hue  bg thr  morph   area  roi" << std::endl;
+    for (size_t i = 0; i < front.size(); ++i) {
+        const DetectionTuningResult& result = front[i];
+        std::cout << std::setw(7) << i << std::setw(10) << result.ms_per_frame << std::setw(10) << result.error.rmse_mm << std::setw(6)
+                  << std::setprecision(0) << result.params.hsv_lower[0] << std::setw(8)
+                  << result.params.background_threshold << std::setw(7) << result.params.morphology_iterations
+                  << std::setw(7) << result.params.area_threshold << std::setw(5) << result.params.flow_roi_size
+                  << std::setprecision(2) << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout.precision(6);
+
+    if (!tuner.output.empty()) {
+        writeTuningResultsCsv(results, tuner.output);
+    }
+    if (!tuner.front_output.empty()) {
+        writeParetoFrontJson(front, tuner.front_output);
+    }
+    return results;
+}
+
+#endif // TUNER_H
@@ -0,0 +1,77 @@
+#ifndef UNDISTORT_H
+#define UNDISTORT_H
+
+#include <cmath>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Undistorts single image points with the OpenCV (Brown-Conrady + rational) lens model.
+// Only the detected centroids go through it, so frames are never remapped.
+class PointUndistorter {
+public:
+    PointUndistorter() = default;
+
+    // dist holds (k1, k2, p1, p2[, k3[, k4, k5, k6]]), an empty vector disables undistortion
+    PointUndistorter(const std::vector<std::vector<double>>& K, const std::vector<double>& dist) {
+        fx = K[0][0];
+        fy = K[1][1];
+        cx = K[0][2];
+        cy = K[1][2];
+        skew = K[0][1];
+
+        for (size_t i = 0; i < dist.size() && i < 8; ++i) {
+            coeffs[i] = dist[i];
+            enabled = enabled || dist[i] != 0.0;
+        }
+    }
+
+    bool isEnabled() const { return enabled; }
+
+    // Method to map a distorted pixel to the pixel an ideal pinhole camera with the same K would see
+    cv::Point2d undistort(const cv::Point2d& pixel) const {
+        if (!enabled) {
+            return pixel;
+        }
+
+        // Normalized distorted coordinates
+        double y0 = (pixel.y - cy) / fy;
+        double x0 = (pixel.x - cx - skew * y0) / fx;
+        double x = x0;
+        double y = y0;
+
+        const double k1 = coeffs[0], k2 = coeffs[1], p1 = coeffs[2], p2 = coeffs[3];
+        const double k3 = coeffs[4], k4 = coeffs[5], k5 = coeffs[6], k6 = coeffs[7];
+
+        // Fixed point iteration x = (x0 - tangential(x)) / radial(x), converges in a few steps. Strong lenses
+        // converge slower near the image corners, 10 steps still left a strong barrel lens 0.06 px off there.
+        for (int iter = 0; iter < max_iterations; ++iter) {
+            double r2 = x * x + y * y;
+            double r4 = r2 * r2;
+            double r6 = r4 * r2;
+            double icdist = (1.0 + k4 * r2 + k5 * r4 + k6 * r6) / (1.0 + k1 * r2 + k2 * r4 + k3 * r6);
+            double delta_x = 2.0 * p1 * x * y + p2 * (r2 + 2.0 * x * x);
+            double delta_y = p1 * (r2 + 2.0 * y * y) + 2.0 * p2 * x * y;
+            double next_x = (x0 - delta_x) * icdist;
+            double next_y = (y0 - delta_y) * icdist;
+
+            bool converged = std::abs(next_x - x) + std::abs(next_y - y) < epsilon;
+            x = next_x;
+            y = next_y;
+            if (converged) {
+                break;
+            }
+        }
+
+        return cv::Point2d(fx * x + skew * y + cx, fy * y + cy);
+    }
+
+private:
+    double fx = 1.0, fy = 1.0, cx = 0.0, cy = 0.0, skew = 0.0;
+    double coeffs[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    bool enabled = false;
+
+    static constexpr int max_iterations = 20;
+    static constexpr double epsilon = 1e-12;
+};
+
+#endif // UNDISTORT_H
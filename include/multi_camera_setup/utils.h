@@ -5,37 +5,10 @@
 #include <opencv2/opencv.hpp>
 
 #include <filesystem>
+#include "quality.h"
 using namespace cv;
 using namespace std;
 
-// Function to initialize videos for each camera
-void initializeCameraVideos(std::vector<Camera>& cameras, const std::string& videoBasePath) {
-    for (auto& camera : cameras) {
-        std::string videoPath = videoBasePath + camera.name + ".mp4";
-        if (camera.openVideo(videoPath)) {
-            std::cout << "Initialized video for camera: " << camera.name << std::endl;
-        } else {
-            std::cerr << "Error: Failed to open video file for camera: " << camera.name << std::endl;
-        }
-    }
-}
-
-// Function to set backgrounds for each camera
-void setCameraBackgrounds(std::vector<Camera>& cameras, const std::string& backgroundPath) {
-    for (auto& camera : cameras) {
-        std::string backgroundFilePath = backgroundPath + camera.name + "_background.png";
-        cv::Mat background = cv::imread(backgroundFilePath);
-
-        if (background.empty()) {
-            std::cerr << "Error: Background image not loaded correctly for camera: " << camera.name << std::endl;
-        } else {
-            camera.setBackground(background);
-            // Debug output for background image size
-            std::cout << "Loaded background for camera: " << camera.name << " of size: " << background.size() << std::endl;
-        }
-    }
-}
-
 //function to visualize the output
 void visualizeOutput(Camera &camera)
 {
@@ -58,17 +31,15 @@ void visualizeOutput(Camera &camera)
         waitKey(1);
 }
 
-// Function to check if the tracking is active
-bool checkDetectionActive(int frame_index, int cameras_num, Camera &camera)
+// Function to check if the detection is active, each camera detects once every detection_period frames.
+// With a period equal to the number of cameras exactly one camera detects per frame, in turn.
+bool checkDetectionActive(int frame_index, int detection_period, Camera &camera)
 {
-
-    int active_index = frame_index % cameras_num;
-    if (active_index == 0)
+    if (detection_period <= 1)
     {
-        active_index = cameras_num;
+        return true;
     }
-    return (camera.index == active_index);
-
+    return ((frame_index - camera.index) % detection_period + detection_period) % detection_period == 0;
 }
 
 
@@ -88,21 +59,20 @@ vector<Point> findContoursInMask(const Mat &mask, float areaThreshold) {
     return filteredContour;
 }
 
-cv::Point2f getPositionFromContour(Mat &frame, vector<Point> &contour, Point2f &tracker_pos, Point2f &previous_tracker_pos) 
+cv::Point2f getPositionFromContour(const vector<Point> &contour, Point2f &tracker_pos, float &radius)
 {
-    float radius;
     // Get the minimum enclosing circle
     minEnclosingCircle(contour, tracker_pos, radius);
-    
-    
-    // Draw the circle
-    cv::Point tracker_pos_int = cv::Point(cvRound(tracker_pos.x), cvRound(tracker_pos.y));;
-    circle(frame, tracker_pos_int, cvRound(radius), Scalar(0, 255, 0), 2); 
-    
-   
     return tracker_pos;
 }
 
+// Draw the detected ball
+void visualizeDetection(Mat &frame, const Point2f &tracker_pos, float radius)
+{
+    cv::Point tracker_pos_int = cv::Point(cvRound(tracker_pos.x), cvRound(tracker_pos.y));
+    circle(frame, tracker_pos_int, cvRound(radius), Scalar(0, 255, 0), 2);
+}
+
 
 void visualizeSpeed(const Point2f &prev_point, const Point2f &curr_point, Mat &frame) {
     // Calculate the direction vector
@@ -118,68 +88,54 @@ void visualizeSpeed(const Point2f &prev_point, const Point2f &curr_point, Mat &f
 }
 
 
-cv::Point3d triangulatePoint(const std::vector<Camera>& cameras, const std::vector<cv::Point2d>& imagePoints) {
-    if (cameras.size() != imagePoints.size()) {
+cv::Point3d triangulatePoint(const std::vector<cv::Mat>& projectionMatrices, const std::vector<cv::Point2d>& imagePoints,
+                             TriangulationQuality* quality = nullptr) {
+    if (projectionMatrices.size() != imagePoints.size()) {
         throw std::invalid_argument("Number of cameras must match the number of image points.");
     }
 
-    std::vector<cv::Mat> projectionMatrices;
-    for (const auto& camera : cameras) {
-        projectionMatrices.push_back(camera.getProjectionMatrix());
+    // Fixed size DLT kernel for the camera count, see dlt.h
+    std::vector<cv::Matx34d> projections;
+    projections.reserve(projectionMatrices.size());
+    for (const cv::Mat& P : projectionMatrices) {
+        projections.push_back(cv::Matx34d(P));
     }
-
-    // Matrix to hold the linear system of equations
-    cv::Mat A = cv::Mat::zeros(2 * (int)cameras.size(), 4, CV_64F);
-
-    // Fill the matrix A
-    for (int i = 0; i < (int)cameras.size(); ++i) {
-        double x = imagePoints[i].x;
-        double y = imagePoints[i].y;
-        const cv::Mat& P = projectionMatrices[i];
-
-        A.row(2 * i)     = x * P.row(2) - P.row(0);
-        A.row(2 * i + 1) = y * P.row(2) - P.row(1);
+    cv::Vec4d singularValues;
+    cv::Point3d point3D = selectDltKernel(projections.size())(projections.data(), imagePoints.data(),
+                                                              projections.size(), singularValues);
+
+    // Optional quality metrics, reusing the projection matrices and singular values
+    if (quality) {
+        computeTriangulationQuality(projectionMatrices, imagePoints, cv::Mat(4, 1, CV_64F, singularValues.val),
+                                    point3D, *quality);
     }
 
-    // Perform SVD
-    cv::Mat w, u, vt;
-    cv::SVD::compute(A, w, u, vt);
-
-    // The solution is the last row of Vt
-    cv::Mat point4D = vt.row(3).t();
-
-    // Convert from homogeneous coordinates to 3D
-    cv::Point3d point3D(
-        point4D.at<double>(0) / point4D.at<double>(3),
-        point4D.at<double>(1) / point4D.at<double>(3),
-        point4D.at<double>(2) / point4D.at<double>(3)
-    );
-
     return point3D;
 }
 
+// Function to triangulate this frame's observations of all cameras with the kernel picked for the rig
+cv::Point3d triangulatePoint(const CameraGeometryBlock& geometry, TriangulationQuality* quality = nullptr) {
+    cv::Vec4d singularValues;
+    cv::Point3d point3D = geometry.dlt_kernel(geometry.projections.data(), geometry.image_points.data(),
+                                              geometry.size(), singularValues);
+    if (quality) {
+        computeTriangulationQuality(geometry, cv::Mat(4, 1, CV_64F, singularValues.val), point3D, *quality);
+    }
+    return point3D;
+}
 
-
-cv::Point2f trackPointOpticalFlow(const cv::Mat& previous_frame, const cv::Mat& current_frame, const cv::Point2f& previous_point) {
-    std::vector<cv::Point2f> previous_points(1, previous_point);
-    std::vector<cv::Point2f> current_points;
-    std::vector<uchar> status;
-    std::vector<float> err;
-
-    // Parameters for cv::calcOpticalFlowPyrLK
-    cv::Size winSize = cv::Size(128, 128);
-    int maxLevel = 2;
-    cv::TermCriteria criteria = cv::TermCriteria(cv::TermCriteria::EPS | cv::TermCriteria::COUNT, 10, 0.03);
-
-    // Calculate optical flow to get the new point position
-    cv::calcOpticalFlowPyrLK(previous_frame, current_frame, previous_points, current_points, status, err, winSize, maxLevel, criteria);
-
-    // Check if the flow was found
-    if (status[0] == 1) {
-        return current_points[0];
-    } else {
-        return previous_point;
+// Function to collect the projection matrix of every camera
+std::vector<cv::Mat> getProjectionMatrices(const std::vector<Camera>& cameras) {
+    std::vector<cv::Mat> projectionMatrices;
+    for (const auto& camera : cameras) {
+        projectionMatrices.push_back(camera.getProjectionMatrix());
     }
+    return projectionMatrices;
+}
+
+cv::Point3d triangulatePoint(const std::vector<Camera>& cameras, const std::vector<cv::Point2d>& imagePoints,
+                             TriangulationQuality* quality = nullptr) {
+    return triangulatePoint(getProjectionMatrices(cameras), imagePoints, quality);
 }
 
 
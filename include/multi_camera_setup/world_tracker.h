@@ -0,0 +1,144 @@
+#ifndef WORLD_TRACKER_H
+#define WORLD_TRACKER_H
+
+#include <opencv2/opencv.hpp>
+#include "fixed_kalman.h"
+#include "smoother.h"
+
+// Tuning of the world space tracker
+struct WorldTrackerConfig {
+    double acceleration_noise = 20.0; // White acceleration noise density (m^2/s^3)
+    double pixel_noise = 2.0; // Standard deviation of a 2D observation in pixels
+    double initial_position_sigma = 0.05; // Meters, after initialization from a triangulation
+    double initial_velocity_sigma = 2.0; // Meters per second
+    double gate = 25.0; // Mahalanobis gate on the 2D innovation (chi2 with 2 dof)
+    bool use_gravity = false; // Add a known constant acceleration to the motion model
+    cv::Vec3d gravity = cv::Vec3d(0.0, -9.81, 0.0); // World frame gravity (m/s^2)
+};
+
+// Extended Kalman filter over (X, Y, Z, VX, VY, VZ) that takes each camera's 2D observation
+// as a measurement through its projection matrix, whenever that camera reports.
+class WorldTracker {
+public:
+    typedef FixedKalmanFilter<6, 2, double> Filter;
+
+    explicit WorldTracker(const WorldTrackerConfig& config = WorldTrackerConfig())
+    : config(config) {}
+
+    bool isInitialized() const { return initialized; }
+
+    // Method to start tracking from a known position, e.g. a one-off triangulation
+    void initialize(const cv::Point3d& position, double timestamp) {
+        KF.state = Filter::StateVec(position.x, position.y, position.z, 0.0, 0.0, 0.0);
+        KF.covariance = Filter::StateMat::zeros();
+        double p2 = config.initial_position_sigma * config.initial_position_sigma;
+        double v2 = config.initial_velocity_sigma * config.initial_velocity_sigma;
+        for (int i = 0; i < 3; ++i) {
+            KF.covariance(i, i) = p2;
+            KF.covariance(i + 3, i + 3) = v2;
+        }
+        KF.measurement_noise = Filter::MeasMat::eye() * (config.pixel_noise * config.pixel_noise);
+        last_timestamp = timestamp;
+        initialized = true;
+
+        predicted_state = KF.state;
+        predicted_covariance = KF.covariance;
+        last_transition = Filter::StateMat::eye();
+    }
+
+    // Method to propagate the state to the given time (seconds), no-op for past timestamps
+    void predict(double timestamp) {
+        double dt = timestamp - last_timestamp;
+        if (!initialized || dt <= 0.0) {
+            return;
+        }
+
+        // Constant velocity with piecewise white acceleration noise
+        double q = config.acceleration_noise;
+        KF.transition = Filter::StateMat::eye();
+        KF.process_noise = Filter::StateMat::zeros();
+        for (int i = 0; i < 3; ++i) {
+            KF.transition(i, i + 3) = dt;
+            KF.process_noise(i, i) = q * dt * dt * dt / 3.0;
+            KF.process_noise(i, i + 3) = q * dt * dt / 2.0;
+            KF.process_noise(i + 3, i) = q * dt * dt / 2.0;
+            KF.process_noise(i + 3, i + 3) = q * dt;
+        }
+        KF.predict();
+
+        if (config.use_gravity) {
+            for (int i = 0; i < 3; ++i) {
+                KF.state(i) += 0.5 * config.gravity[i] * dt * dt;
+                KF.state(i + 3) += config.gravity[i] * dt;
+            }
+        }
+        last_timestamp = timestamp;
+
+        predicted_state = KF.state;
+        predicted_covariance = KF.covariance;
+        last_transition = KF.transition;
+    }
+
+    // Method to fuse one camera's pixel observation, returns false if it was gated out
+    bool update(const cv::Matx34d& P, const cv::Point2d& observation) {
+        if (!initialized) {
+            return false;
+        }
+
+        cv::Vec4d X(KF.state(0), KF.state(1), KF.state(2), 1.0);
+        cv::Vec3d x = P * X;
+        if (x[2] <= 0.0) {
+            return false; // Behind the camera, the linearization is meaningless
+        }
+        double u = x[0] / x[2];
+        double v = x[1] / x[2];
+
+        // Jacobian of the perspective projection with respect to the position
+        Filter::MeasStateMat H = Filter::MeasStateMat::zeros();
+        double inv_w = 1.0 / x[2];
+        for (int j = 0; j < 3; ++j) {
+            H(0, j) = (P(0, j) - u * P(2, j)) * inv_w;
+            H(1, j) = (P(1, j) - v * P(2, j)) * inv_w;
+        }
+
+        Filter::MeasVec innovation(observation.x - u, observation.y - v);
+        Filter::MeasMat S = H * KF.covariance * H.t() + KF.measurement_noise;
+        double mahalanobis = (innovation.t() * S.inv() * innovation)(0);
+        if (mahalanobis > config.gate) {
+            return false;
+        }
+
+        // EKF step as a linear correction on the linearized measurement z - h(x) + H x
+        KF.measurement_matrix = H;
+        KF.correct(innovation + H * KF.state);
+        return true;
+    }
+
+    cv::Point3d position() const { return cv::Point3d(KF.state(0), KF.state(1), KF.state(2)); }
+    cv::Vec3d velocity() const { return cv::Vec3d(KF.state(3), KF.state(4), KF.state(5)); }
+    double timestamp() const { return last_timestamp; }
+    const Filter& filter() const { return KF; }
+
+    // Method to package the last predict and the updates since into a step for the RTS smoother
+    SmootherStep<6> smootherStep(int frame_index) const {
+        SmootherStep<6> step;
+        step.frame_index = frame_index;
+        step.predicted_state = predicted_state;
+        step.predicted_covariance = predicted_covariance;
+        step.transition = last_transition;
+        step.filtered_state = KF.state;
+        step.filtered_covariance = KF.covariance;
+        return step;
+    }
+
+private:
+    WorldTrackerConfig config;
+    Filter KF;
+    Filter::StateVec predicted_state;
+    Filter::StateMat predicted_covariance;
+    Filter::StateMat last_transition;
+    double last_timestamp = 0.0;
+    bool initialized = false;
+};
+
+#endif // WORLD_TRACKER_H
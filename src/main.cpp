@@ -4,82 +4,606 @@
 #include <tbb/parallel_for.h>
 #include <tbb/blocked_range.h>
 #include "multi_camera_setup/camera.h"
+#include "multi_camera_setup/camera_rig.h"
 #include "multi_camera_setup/camera_parameters.h"
+#include "multi_camera_setup/calibration_bundle.h"
 #include "multi_camera_setup/utils.h"
 #include "multi_camera_setup/tracking.h"
+#include "multi_camera_setup/pipeline_config.h"
+#include "multi_camera_setup/startup.h"
+#include "multi_camera_setup/synthetic_scene.h"
+#include "multi_camera_setup/metrics.h"
+#include "multi_camera_setup/evaluator.h"
+#include "multi_camera_setup/observation_log.h"
+#include "multi_camera_setup/stage_cache.h"
+#include "multi_camera_setup/tuner.h"
 #include <filesystem>
+#include <chrono>
+#include <thread>
 
 // Function to process a camera's frame
-void processCameraFrame(Camera& camera, int frame_index, int cameras_num) {
-    camera.readNextFrame();
-    if (!camera.current_frame.empty()) {
-        trackBallInFrame(camera, frame_index, cameras_num);
+void processCameraFrame(Camera& camera, int frame_index, const PipelineConfig& config) {
+    MCS_STAGE_SCOPE(Stage::Camera, camera.index);
+    bool read;
+    {
+        MCS_STAGE_SCOPE(Stage::Decode, camera.index);
+        read = camera.readNextFrame();
     }
-}
+    if (!read) {
+        MCS_FRAME_DROPPED(camera.index);
+    }
+    if (!camera.current_frame.empty()) {
+        auto start = std::chrono::steady_clock::now();
+
+        // The adaptive scheduler has already picked this camera's tracker
+        TrackerMode mode = config.use_adaptive_scheduler
+                               ? camera.state->tracker_mode
+                               : selectRoundRobinMode(camera, frame_index, config.detection_period,
+                                                      config.fusion.interframe_mode);
+        trackBallInFrame(camera, mode, config.fusion, config.detection);
+        camera.state->undistorted_position = camera.getUndistortedTrackerPosition();
 
-// Function to initialize cameras from loaded parameters
-void Initialize_cameras_parameters(std::vector<CameraData>& cameraParams, std::vector<Camera>& cameras) {
-    int index = 1;
-    for (const auto& param : cameraParams) {
-        cameras.emplace_back(param.name, param.tvec, param.rvec, param.K, index);
-        index++;
+        camera.state->tracking_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
     }
 }
 
-void processParallelCameraFrames(std::vector<Camera>& cameras, int cameras_num, int video_length) {
-    std::filesystem::path project_path = findProjectRoot(PROJECT_NAME);
-    std::string csvFilePath = (project_path / "csv_files" / "ball_pos_real.csv").string();
-    std::ofstream myfile(csvFilePath);
+// Function to run the frame loop, returns false if the trajectory misses the accuracy thresholds of
+// the evaluation against groundTruth (skipped when groundTruth is empty). With a replay log the
+// observations come from the log instead of tracking the cameras' frames.
+bool processParallelCameraFrames(CameraRig& rig, int video_length, const PipelineConfig& config,
+                                 const std::vector<cv::Point3d>& groundTruth, const ObservationLog* replay = nullptr) {
+    std::vector<Camera>& cameras = rig.cameras;
+    CameraGeometryBlock& geometry = rig.geometry;
+
+    std::ofstream myfile(config.trajectory_output);
+    TrajectoryEvaluator evaluator(config.evaluation);
+
+    ObservationLogWriter recorder;
+    if (!config.record_output.empty()) {
+        recorder.open(config.record_output, cameras.size(), config.fps);
+    }
 
     tbb::blocked_range<size_t> range(0, cameras.size());
-    std::vector<cv::Point2d> imagePoints(cameras.size());
+
+    QualityMonitor qualityMonitor(cameras.size());
+    TriangulationQuality quality;
+
+    WorldTracker worldTracker(config.world_tracker);
+    AdaptiveScheduler scheduler(config.scheduler);
+
+    // Offline RTS smoothing of the world tracker states, emitted in blocks behind the live output
+    std::ofstream smoothedFile;
+    if (config.write_smoothed) {
+        smoothedFile.open(config.smoothed_trajectory_output);
+    }
+    BlockRtsSmoother<6> smoother(config.smoother.block_size, config.smoother.lag, [&](const SmootherStep<6>& step) {
+        smoothedFile << step.filtered_state(0) << "," << step.filtered_state(1) << "," << step.filtered_state(2) << "\n";
+    });
+
+#ifdef MCS_ENABLE_METRICS
+    PipelineMetrics& metrics = PipelineMetrics::instance();
+    metrics.configure(static_cast<int>(cameras.size()));
+#if !defined(_WIN32)
+    MetricsSocketServer metricsServer;
+    if (!config.metrics_socket.empty()) {
+        metricsServer.start(config.metrics_socket);
+    }
+#endif
+    auto last_metrics_report = std::chrono::steady_clock::now();
+#endif
 
     for (int frame_index = 0; frame_index < video_length; frame_index++) {
-        tbb::parallel_for(range, [&](const tbb::blocked_range<size_t>& range) {
-            for (size_t i = range.begin(); i != range.end(); ++i) {
-                processCameraFrame(cameras[i], frame_index, cameras_num);
+        MCS_TRACE_FRAME(frame_index);
+        MCS_STAGE_SCOPE(Stage::Frame, 0);
+        if (replay) {
+            replay->restore(frame_index, rig.states);
+        } else {
+            if (config.use_adaptive_scheduler) {
+                scheduler.schedule(cameras, frame_index, config.detection_period, config.fusion.interframe_mode);
             }
-        });
 
-        for (size_t i = 0; i < cameras.size(); ++i) {
-            imagePoints[i] = cameras[i].current_tracker_position;
+            tbb::parallel_for(range, [&](const tbb::blocked_range<size_t>& range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    processCameraFrame(cameras[i], frame_index, config);
+                }
+            });
+
+            if (config.use_adaptive_scheduler) {
+                scheduler.recordCosts(cameras);
+            }
         }
 
-        cv::Point3d point3D = triangulatePoint(cameras, imagePoints);
-        myfile << point3D.x << "," << point3D.y << "," << point3D.z << "\n";
+        geometry.gather(rig.states);
+        if (recorder.isOpen()) {
+            recorder.write(rig.states);
+        }
 
-        for (auto& camera : cameras) {
-            visualizeOutput(camera);
+        cv::Point3d point3D;
+        {
+            MCS_STAGE_SCOPE(Stage::Triangulation, 0);
+            if (config.use_world_tracker) {
+                point3D = fuseCameraObservations(geometry, worldTracker, frame_index / config.fps);
+                computeTriangulationQuality(geometry, cv::Mat(), point3D, quality);
+
+                if (config.write_smoothed) {
+                    if (worldTracker.isInitialized()) {
+                        smoother.push(worldTracker.smootherStep(frame_index));
+                    } else {
+                        smoothedFile << point3D.x << "," << point3D.y << "," << point3D.z << "\n";
+                    }
+                }
+            } else {
+                point3D = triangulateValidObservations(geometry, &quality);
+            }
+        }
+        qualityMonitor.record(quality);
+        if (static_cast<size_t>(frame_index) < groundTruth.size()) {
+            evaluator.add(point3D, groundTruth[frame_index]);
+        }
+        {
+            MCS_STAGE_SCOPE(Stage::Output, 0);
+            myfile << point3D.x << "," << point3D.y << "," << point3D.z << "\n";
         }
 
-         // Debug output
-        std::cout << "position at frame " << frame_index << ": " << point3D << std::endl;
+        if (config.display && !replay) {
+            MCS_STAGE_SCOPE(Stage::Display, 0);
+            for (auto& camera : cameras) {
+                visualizeOutput(camera);
+            }
+        }
+        MCS_FRAME_DONE();
+
+#ifdef MCS_ENABLE_METRICS
+        auto now = std::chrono::steady_clock::now();
+        if (config.metrics_interval > 0.0 &&
+            std::chrono::duration<double>(now - last_metrics_report).count() >= config.metrics_interval) {
+            last_metrics_report = now;
+            metrics.printSummary();
+            if (!config.metrics_file.empty()) {
+                metrics.writePrometheusFile(config.metrics_file);
+            }
+        }
+#endif
+
+        // Debug output, left out of replays so they run at memory speed
+        if (replay) {
+            continue;
+        }
+        std::cout << "position at frame " << frame_index << ": " << point3D
+                  << " angle: " << quality.triangulation_angle << " cond: " << quality.condition_number << std::endl;
         for (auto& camera : cameras) {
-            std::cout << "Camera " << camera.index << " is tracking active: " << camera.is_detection_active << std::endl;
+            std::cout << "Camera " << camera.index << " is tracking active: " << camera.state->is_detection_active
+                      << " reprojection error: " << quality.reprojection_errors[camera.index - 1] << std::endl;
         }
     }
     myfile.close();
+
+    if (config.write_smoothed) {
+        smoother.flush();
+        smoothedFile.close();
+    }
+
+#ifdef MCS_ENABLE_METRICS
+    metrics.printSummary();
+    if (!config.metrics_file.empty()) {
+        metrics.writePrometheusFile(config.metrics_file);
+    }
+#endif
+
+    qualityMonitor.printSummary();
+    qualityMonitor.exportCsv(config.quality_output);
+
+    return groundTruth.empty() || evaluator.finish("Trajectory");
 }
 
-int main() {
+// Function to run the frame loop with quorum fusion. Every camera tracks its frames on its own thread and
+// hands each observation to fusion on this thread, which outputs a frame as soon as config.quorum.quorum
+// valid observations of it are in. With config.quorum.refined_output the point triangulated from every
+// camera is written once the last camera reported. Returns false like processParallelCameraFrames.
+bool processQuorumCameraFrames(CameraRig& rig, int video_length, const PipelineConfig& config,
+                               const std::vector<cv::Point3d>& groundTruth) {
+    std::vector<Camera>& cameras = rig.cameras;
+
+    std::ofstream myfile(config.trajectory_output);
+    std::ofstream refinedFile;
+    if (!config.quorum.refined_output.empty()) {
+        refinedFile.open(config.quorum.refined_output);
+    }
+    TrajectoryEvaluator evaluator(config.evaluation);
+    TrajectoryEvaluator refinedEvaluator;
+
+    QualityMonitor qualityMonitor(cameras.size());
+    TriangulationQuality quality;
+    WorldTracker worldTracker(config.world_tracker);
+
+    std::ofstream smoothedFile;
+    if (config.write_smoothed) {
+        smoothedFile.open(config.smoothed_trajectory_output);
+    }
+    BlockRtsSmoother<6> smoother(config.smoother.block_size, config.smoother.lag, [&](const SmootherStep<6>& step) {
+        smoothedFile << step.filtered_state(0) << "," << step.filtered_state(1) << "," << step.filtered_state(2) << "\n";
+    });
+
+#ifdef MCS_ENABLE_METRICS
+    PipelineMetrics& metrics = PipelineMetrics::instance();
+    metrics.configure(static_cast<int>(cameras.size()));
+#if !defined(_WIN32)
+    MetricsSocketServer metricsServer;
+    if (!config.metrics_socket.empty()) {
+        metricsServer.start(config.metrics_socket);
+    }
+#endif
+    auto last_metrics_report = std::chrono::steady_clock::now();
+#endif
+
+    // Live points by frame, the quality of a point is measured against every camera once all reported
+    std::vector<cv::Point3d> livePoints(video_length);
+
+    QuorumFusion fusion(
+        rig.geometry, config.quorum,
+        [&](int frame_index, const CameraGeometryBlock& observations) {
+            MCS_TRACE_THREAD_FRAME(frame_index);
+            cv::Point3d point3D;
+            {
+                MCS_STAGE_SCOPE(Stage::Triangulation, 0);
+                if (config.use_world_tracker) {
+                    point3D = fuseCameraObservations(observations, worldTracker, frame_index / config.fps);
+                    if (config.write_smoothed) {
+                        if (worldTracker.isInitialized()) {
+                            smoother.push(worldTracker.smootherStep(frame_index));
+                        } else {
+                            smoothedFile << point3D.x << "," << point3D.y << "," << point3D.z << "\n";
+                        }
+                    }
+                } else {
+                    point3D = triangulateValidObservations(observations);
+                }
+            }
+            livePoints[frame_index] = point3D;
+            if (static_cast<size_t>(frame_index) < groundTruth.size()) {
+                evaluator.add(point3D, groundTruth[frame_index]);
+            }
+            {
+                MCS_STAGE_SCOPE(Stage::Output, 0);
+                myfile << point3D.x << "," << point3D.y << "," << point3D.z << "\n";
+            }
+        },
+        [&](int frame_index, const CameraGeometryBlock& observations) {
+            computeTriangulationQuality(observations, cv::Mat(), livePoints[frame_index], quality);
+            qualityMonitor.record(quality);
+            if (refinedFile.is_open()) {
+                cv::Point3d refined = triangulatePoint(observations);
+                refinedFile << refined.x << "," << refined.y << "," << refined.z << "\n";
+                if (static_cast<size_t>(frame_index) < groundTruth.size()) {
+                    refinedEvaluator.add(refined, groundTruth[frame_index]);
+                }
+            }
+            MCS_FRAME_DONE();
+
+#ifdef MCS_ENABLE_METRICS
+            auto now = std::chrono::steady_clock::now();
+            if (config.metrics_interval > 0.0 &&
+                std::chrono::duration<double>(now - last_metrics_report).count() >= config.metrics_interval) {
+                last_metrics_report = now;
+                metrics.printSummary();
+                if (!config.metrics_file.empty()) {
+                    metrics.writePrometheusFile(config.metrics_file);
+                }
+            }
+#endif
+        });
+
+    // A camera runs at most the window of frames ahead, so the queue never fills
+    MpscQueue<CameraObservation, BlockingWaitPolicy> observations(cameras.size() * fusion.windowSize());
+    std::vector<std::thread> cameraThreads;
+    for (size_t i = 0; i < cameras.size(); ++i) {
+        cameraThreads.emplace_back([&, i]() {
+            Camera& camera = cameras[i];
+            for (int frame_index = 0; frame_index < video_length; frame_index++) {
+                fusion.waitForWindow(frame_index);
+                MCS_TRACE_THREAD_FRAME(frame_index); // This camera's frame, fusion is behind
+                processCameraFrame(camera, frame_index, config);
+                observations.push(CameraObservation{frame_index, static_cast<int>(i), camera.state->undistorted_position,
+                                                    static_cast<uint8_t>(camera.state->is_detection_valid ? 1 : 0)});
+            }
+        });
+    }
+
+    CameraObservation batch[64];
+    while (fusion.completedFrames() < video_length) {
+        size_t popped = observations.popBatch(batch, 64);
+        for (size_t i = 0; i < popped; ++i) {
+            fusion.add(batch[i]);
+        }
+    }
+    for (std::thread& thread : cameraThreads) {
+        thread.join();
+    }
+    myfile.close();
+
+    if (config.write_smoothed) {
+        smoother.flush();
+        smoothedFile.close();
+    }
+
+#ifdef MCS_ENABLE_METRICS
+    metrics.printSummary();
+    if (!config.metrics_file.empty()) {
+        metrics.writePrometheusFile(config.metrics_file);
+    }
+#endif
+
+    std::vector<std::string> cameraNames;
+    for (const Camera& camera : cameras) {
+        cameraNames.push_back(camera.name);
+    }
+    fusion.printSummary(cameraNames);
+    qualityMonitor.printSummary();
+    qualityMonitor.exportCsv(config.quality_output);
+
+    if (refinedFile.is_open() && !groundTruth.empty()) {
+        refinedEvaluator.print("Refined");
+    }
+    return groundTruth.empty() || evaluator.finish("Trajectory");
+}
+
+int main(int argc, char** argv) {
+    PipelineConfig config = parsePipelineArgs(argc, argv);
+
+    // Offline smoothing of an existing trajectory, no videos needed
+    if (!config.smooth_input.empty()) {
+        config.smoother.fps = config.fps;
+        if (!smoothTrajectoryCsv(config.smooth_input, config.smooth_output, config.smoother)) {
+            return 1;
+        }
+        if (!config.ground_truth.empty()) {
+            TrajectoryEvaluator input, smoothed(config.evaluation);
+            evaluateTrajectoryFiles(config.smooth_input, config.ground_truth, input);
+            evaluateTrajectoryFiles(config.smooth_output, config.ground_truth, smoothed);
+            input.print("Input");
+            return smoothed.finish("Smoothed") ? 0 : 1;
+        }
+        return 0;
+    }
+
     std::filesystem::path project_path = findProjectRoot(PROJECT_NAME);
+    if (config.trajectory_output.empty()) {
+        config.trajectory_output = (project_path / "csv_files" / "ball_pos_real.csv").string();
+    }
+    config.smoothed_trajectory_output = (project_path / "csv_files" / "ball_pos_smoothed.csv").string();
+    if (config.quality_output.empty()) {
+        config.quality_output = (project_path / "csv_files" / "quality_histograms.csv").string();
+    }
+
+    // Offline accuracy check of an existing trajectory, thresholds turn it into a pass/fail exit code
+    if (!config.evaluate_input.empty()) {
+        std::string groundTruthPath = config.ground_truth.empty()
+                                          ? (project_path / "csv_files" / "ball_pos_gt.csv").string()
+                                          : config.ground_truth;
+        TrajectoryEvaluator evaluator(config.evaluation);
+        if (!evaluateTrajectoryFiles(config.evaluate_input, groundTruthPath, evaluator)) {
+            return 1;
+        }
+        return evaluator.finish(config.evaluate_input) ? 0 : 1;
+    }
 
     std::string jsonFilePath = (project_path / "calibration" / "cameras.json").string();
-    std::vector<CameraData> cameraParams = loadCameraParamsFromJson(jsonFilePath);
+    std::string bundlePath = config.calibration_bundle.empty()
+                                 ? (project_path / "calibration" / "cameras.bundle").string()
+                                 : config.calibration_bundle;
 
-    std::vector<Camera> cameras;
-    Initialize_cameras_parameters(cameraParams, cameras);
+    if (config.compile_calibration) {
+        return compileCalibrationBundle(jsonFilePath, bundlePath) ? 0 : 1;
+    }
+
+    auto startup_start = std::chrono::steady_clock::now();
+    StartupReport startup;
+
+    // Prefer the compiled bundle unless cameras.json was edited after it was compiled
+    CalibrationBundle bundle;
+    std::error_code error;
+    bool bundleCurrent = std::filesystem::exists(bundlePath, error) &&
+                         (!config.calibration_bundle.empty() || !std::filesystem::exists(jsonFilePath, error) ||
+                          std::filesystem::last_write_time(bundlePath, error) >=
+                              std::filesystem::last_write_time(jsonFilePath, error));
+    std::vector<CameraData> cameraParams;
+    if (bundleCurrent && bundle.open(bundlePath)) {
+        std::cout << "Using calibration bundle " << bundlePath << std::endl;
+        cameraParams = bundle.cameraData();
+    } else {
+        cameraParams = loadCameraParamsFromJson(jsonFilePath);
+    }
+
+    // Synthetic scene on the calibration rig or on a procedural ring of cameras
+    std::shared_ptr<const SyntheticScene> scene;
+    bool proceduralRig = config.synthetic_cameras > 0;
+    if (config.synthetic || !config.synthesize_output.empty()) {
+        if (proceduralRig) {
+            cameraParams = makeProceduralRig(config.synthetic_cameras, config.scene.frame_size);
+        }
+        std::vector<cv::Point3d> trajectory =
+            config.synthetic_frames > 0
+                ? makeBallisticTrajectory(config.synthetic_frames, config.scene.fps, cv::Point3d(-1.0, 0.05, -1.0),
+                                          cv::Point3d(0.3, 4.0, 0.3), config.scene.ball_radius)
+                : loadTrajectoryCsv((project_path / "csv_files" / "ball_pos_gt.csv").string());
+        scene = std::make_shared<const SyntheticScene>(cameraParams, trajectory, config.scene);
+
+        if (!config.synthesize_output.empty()) {
+            return writeSyntheticScene(*scene, config.synthesize_output) ? 0 : 1;
+        }
+    }
+
+    CameraRig rig(cameraParams);
+    std::vector<Camera>& cameras = rig.cameras;
+    rig.geometry.setProjectionMatrices(bundle.isOpen() && !proceduralRig ? bundle.projectionMatrices()
+                                                                          : getProjectionMatrices(cameras));
+    configureFlowTrackers(cameras, config.detection);
+    startup.calibration_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startup_start).count();
 
     std::string videoBasePath = (project_path / "videos/").string();
     std::string backgroundPath = videoBasePath + "background/";
 
-    initializeCameraVideos(cameras, videoBasePath);
-    setCameraBackgrounds(cameras, backgroundPath);
+    // Quorum fusion tracks live frames on per camera threads, which leaves no frame wide step for the
+    // adaptive schedule, the recorder or the windows, and its output depends on timing so it is not cached
+    if (config.quorum.quorum > 0 && (config.use_adaptive_scheduler || !config.replay_input.empty() ||
+                                     !config.record_output.empty())) {
+        std::cerr << "--quorum cannot be combined with --adaptive, --record or --replay, ignoring it" << std::endl;
+        config.quorum.quorum = 0;
+    }
+
+    // Stage cache: an earlier run with the same inputs and tracking options left its 2D observations,
+    // replay them instead of tracking, otherwise record them for the next run
+    StageCache cache(config.cache_dir);
+    uint64_t observationsKey = 0;
+    std::string observationsRecording;
+    // The adaptive schedule picks trackers from measured wall clock costs, so its observations are not a
+    // function of the inputs and are left out like the timing dependent quorum runs
+    if (cache.isEnabled() && config.replay_input.empty() && !config.tune && config.quorum.quorum == 0 &&
+        !config.use_adaptive_scheduler) {
+        Fnv1a64 inputs;
+        if (scene) {
+            hashSyntheticScene(inputs, config.scene, scene->groundTruth());
+        } else {
+            for (const Camera& camera : cameras) {
+                inputs.add(cache.fileHash(videoBasePath + camera.name + ".mp4"));
+                inputs.add(cache.fileHash(backgroundPath + camera.name + "_background.png"));
+            }
+        }
+        observationsKey = observationsCacheKey(inputs.digest(), cameraParams, config);
+        if (cache.contains("observations", observationsKey, ".log")) {
+            std::cout << "Stage cache hit: observations " << hashHex(observationsKey) << std::endl;
+            config.replay_input = cache.entryPath("observations", observationsKey, ".log");
+        } else {
+            if (config.record_output.empty()) {
+                config.record_output = cache.partialPath("observations", observationsKey, ".log");
+            }
+            observationsRecording = config.record_output;
+        }
+    }
+
+    // Replay of recorded observations, no frames are read at all
+    ObservationLog replayLog;
+    if (!config.replay_input.empty()) {
+        if (!replayLog.open(config.replay_input)) {
+            return 1;
+        }
+        if (replayLog.camerasNum() != cameras.size()) {
+            std::cerr << "Observation log " << config.replay_input << " has " << replayLog.camerasNum()
+                      << " cameras, the calibration " << cameras.size() << std::endl;
+            return 1;
+        }
+    }
 
-    int video_length = static_cast<int>(cameras[0].capture.get(cv::CAP_PROP_FRAME_COUNT));
+    if (replayLog.isOpen()) {
+        std::cout << "Replaying " << replayLog.framesNum() << " frames from " << config.replay_input << std::endl;
+    } else if (scene) {
+        for (size_t i = 0; i < cameras.size(); ++i) {
+            cameras[i].setFrameSource(std::make_shared<SyntheticFrameSource>(scene, i));
+            cameras[i].setBackground(scene->background(i));
+        }
+    } else {
+        initializeCameras(cameras, videoBasePath, backgroundPath, config.prefetch_frames, startup);
+    }
+    startup.total_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startup_start).count();
+    startup.print();
+
+    int video_length = replayLog.isOpen() ? static_cast<int>(replayLog.framesNum()) : cameras[0].frame_count;
     int cameras_num = static_cast<int>(cameras.size());
 
-    processParallelCameraFrames(cameras, cameras_num, video_length);
+    if (config.detection_period <= 0) {
+        config.detection_period = cameras_num;
+    }
+
+    double fps = replayLog.isOpen() ? replayLog.fps() : cameras[0].frame_rate;
+    if (fps > 0.0) {
+        config.fps = fps;
+        config.smoother.fps = fps;
+    }
+
+#ifdef MCS_ENABLE_TRACING
+    if (!config.trace_output.empty()) {
+        PipelineTracer::instance().enable(config.trace_events);
+    }
+#endif
+
+    // Online evaluation against the synthetic scene's trajectory or a given ground truth file
+    std::vector<cv::Point3d> groundTruth;
+    if (scene) {
+        groundTruth = scene->groundTruth();
+    } else if (!config.ground_truth.empty()) {
+        groundTruth = loadTrajectoryCsv(config.ground_truth);
+    }
+
+    // Detection tuning on frames decoded once, instead of a tracking run
+    if (config.tune) {
+        if (groundTruth.empty()) {
+            std::cerr << "Tuning needs a ground truth, run it with --synthetic or --ground-truth" << std::endl;
+            return 1;
+        }
+        if (config.tuner.output.empty()) {
+            config.tuner.output = (project_path / "csv_files" / "detection_tuning.csv").string();
+        }
+        if (config.tuner.front_output.empty()) {
+            config.tuner.front_output = (project_path / "csv_files" / "detection_pareto.json").string();
+        }
+        TuningFrames frames = loadTuningFrames(cameras, config.tuner.frames);
+        runDetectionTuner(config.tuner, config, cameraParams, rig.geometry.projection_matrices, frames, groundTruth);
+        return 0;
+    }
+
+    // A cached trajectory of the same observations and downstream options skips the frame loop entirely
+    uint64_t trajectoryKey = observationsKey != 0 ? trajectoryCacheKey(observationsKey, config) : 0;
+    if (trajectoryKey != 0 && cache.contains("trajectory", trajectoryKey, ".csv") &&
+        (!config.write_smoothed || cache.contains("smoothed", trajectoryKey, ".csv"))) {
+        std::cout << "Stage cache hit: trajectory " << hashHex(trajectoryKey) << std::endl;
+        std::error_code error;
+        std::filesystem::copy_file(cache.entryPath("trajectory", trajectoryKey, ".csv"), config.trajectory_output,
+                                   std::filesystem::copy_options::overwrite_existing, error);
+        if (config.write_smoothed && !error) {
+            std::filesystem::copy_file(cache.entryPath("smoothed", trajectoryKey, ".csv"),
+                                       config.smoothed_trajectory_output,
+                                       std::filesystem::copy_options::overwrite_existing, error);
+        }
+        if (error) {
+            std::cerr << "Could not copy the cached trajectory: " << error.message() << std::endl;
+            return 1;
+        }
+        if (groundTruth.empty()) {
+            return 0;
+        }
+        TrajectoryEvaluator evaluator(config.evaluation);
+        evaluateTrajectoryFile(config.trajectory_output, groundTruth, evaluator);
+        return evaluator.finish("Trajectory") ? 0 : 1;
+    }
+
+    auto run_start = std::chrono::steady_clock::now();
+    bool accurate = config.quorum.quorum > 0
+                        ? processQuorumCameraFrames(rig, video_length, config, groundTruth)
+                        : processParallelCameraFrames(rig, video_length, config, groundTruth,
+                                                      replayLog.isOpen() ? &replayLog : nullptr);
+    if (replayLog.isOpen()) {
+        double run_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - run_start).count();
+        std::cout << "Replayed " << video_length << " frames in " << run_ms << " ms, "
+                  << (run_ms > 0.0 ? video_length / config.fps * 1000.0 / run_ms : 0.0) << "x real time" << std::endl;
+    }
+
+    if (!observationsRecording.empty()) {
+        cache.store("observations", observationsKey, ".log", observationsRecording);
+    }
+    if (trajectoryKey != 0) {
+        cache.store("trajectory", trajectoryKey, ".csv", config.trajectory_output);
+        if (config.write_smoothed) {
+            cache.store("smoothed", trajectoryKey, ".csv", config.smoothed_trajectory_output);
+        }
+    }
+
+#ifdef MCS_ENABLE_TRACING
+    if (!config.trace_output.empty()) {
+        PipelineTracer::instance().write(config.trace_output, traceStageName);
+    }
+#endif
 
-    return 0;
+    return accurate ? 0 : 1;
 }
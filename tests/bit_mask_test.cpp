@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "multi_camera_setup/tracking.h"
+#include "test_utils.h"
+
+// Function to fill an 8 bit mask of 0 and 255 with set pixels at the given density
+cv::Mat makeRandomMask(int rows, int cols, double density, std::mt19937& rng) {
+    std::bernoulli_distribution set(density);
+    cv::Mat mask(rows, cols, CV_8UC1);
+    for (int r = 0; r < rows; ++r) {
+        uchar* row = mask.ptr<uchar>(r);
+        for (int x = 0; x < cols; ++x) {
+            row[x] = set(rng) ? 255 : 0;
+        }
+    }
+    return mask;
+}
+
+// Function to compare a bit mask with an 8 bit one, also checking that the padding bits stayed clear
+bool sameMask(const BitMask& packed, const cv::Mat& expected) {
+    if (packed.rows != expected.rows || packed.cols != expected.cols) {
+        return false;
+    }
+    for (int r = 0; r < packed.rows; ++r) {
+        if (packed.row(r)[packed.words - 1] & ~packed.lastWordMask()) {
+            return false;
+        }
+    }
+    cv::Mat unpacked;
+    packed.unpack(unpacked);
+    return cv::norm(unpacked, expected, cv::NORM_INF) == 0.0;
+}
+
+// Function to check the bit mask morphology against cv::dilate and cv::erode with the default 3x3 kernel
+// and border, on random masks whose widths end mid word, on a word boundary and below one word
+void checkMorphology() {
+    std::mt19937 rng(3);
+    BitMask packed, scratch;
+    for (int cols : {1, 5, 63, 64, 65, 127, 130, 333}) {
+        for (int rows : {1, 2, 7, 40}) {
+            for (double density : {0.05, 0.3, 0.7}) {
+                cv::Mat mask = makeRandomMask(rows, cols, density, rng);
+                std::string label = std::to_string(rows) + "x" + std::to_string(cols) + " mask, density " +
+                                    std::to_string(density);
+
+                cv::Mat expected;
+                cv::dilate(mask, expected, cv::Mat());
+                packed.pack(mask);
+                dilateBitMask3x3(packed, scratch);
+                check(sameMask(packed, expected), label + ": dilate differs from cv::dilate");
+
+                cv::erode(mask, expected, cv::Mat());
+                packed.pack(mask);
+                erodeBitMask3x3(packed, scratch);
+                check(sameMask(packed, expected), label + ": erode differs from cv::erode");
+
+                for (int iterations : {1, 2, 3}) {
+                    cv::dilate(mask, expected, cv::Mat(), cv::Point(-1, -1), iterations);
+                    cv::erode(expected, expected, cv::Mat(), cv::Point(-1, -1), iterations);
+                    packed.pack(mask);
+                    closeBitMask(packed, scratch, iterations);
+                    check(sameMask(packed, expected),
+                          label + ", " + std::to_string(iterations) + " iterations: close differs from OpenCV");
+                }
+            }
+        }
+    }
+}
+
+// Function to check findLargestMaskBlob against the findContoursInMask path it replaced: a ball (a disc,
+// sometimes cut by the image border) among specks below the area threshold gives the same enclosing
+// circle, and a mask of specks alone gives no position in both
+void checkBlobs() {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> radius_of(5, 40);
+    BitMaskWorkspace workspace;
+    const float area_threshold = 50.0f;
+    for (int trial = 0; trial < 200; ++trial) {
+        int cols = 2 * std::uniform_int_distribution<int>(40, 400)(rng) + 1;
+        int rows = std::uniform_int_distribution<int>(60, 300)(rng);
+        cv::Mat mask = cv::Mat::zeros(rows, cols, CV_8UC1);
+        cv::Point centre(std::uniform_int_distribution<int>(-10, cols + 10)(rng),
+                         std::uniform_int_distribution<int>(-10, rows + 10)(rng));
+        int radius = radius_of(rng);
+        if (trial % 10 != 0) {
+            cv::circle(mask, centre, radius, cv::Scalar(255), cv::FILLED);
+        }
+        // A sliver the border left of the ball has a contour area well below its pixel count, the two
+        // paths may then disagree on it
+        int ball_pixels = cv::countNonZero(mask);
+        if (ball_pixels > 0 && ball_pixels <= 4 * area_threshold) {
+            continue;
+        }
+        // Specks of at most 2x2 pixels away from the ball
+        for (int i = 0; i < 30; ++i) {
+            cv::Point speck(std::uniform_int_distribution<int>(0, cols - 2)(rng),
+                            std::uniform_int_distribution<int>(0, rows - 2)(rng));
+            cv::Point offset = speck - centre;
+            if (offset.x * offset.x + offset.y * offset.y > (radius + 4) * (radius + 4)) {
+                cv::rectangle(mask, cv::Rect(speck.x, speck.y, 1 + i % 2, 1 + (i / 2) % 2), cv::Scalar(255),
+                              cv::FILLED);
+            }
+        }
+        std::string label = "blob trial " + std::to_string(trial) + " (" + std::to_string(rows) + "x" +
+                            std::to_string(cols) + ")";
+
+        std::vector<cv::Point> contour = findContoursInMask(mask, area_threshold);
+        workspace.mask.pack(mask);
+        MaskBlob blob;
+        bool found = findLargestMaskBlob(workspace, area_threshold, blob);
+        check(found == (ball_pixels > 0), label + ": findLargestMaskBlob found no ball or a speck");
+        check(contour.empty() == (ball_pixels == 0), label + ": findContoursInMask found no ball or a speck");
+        if (!found || contour.empty()) {
+            continue;
+        }
+
+        cv::Point2f expected_centre, centre_found;
+        float expected_radius, radius_found;
+        getPositionFromContour(contour, expected_centre, expected_radius);
+        getPositionFromContour(workspace.points, centre_found, radius_found);
+        checkNear(centre_found.x, expected_centre.x, 1e-2, label + ": centre x");
+        checkNear(centre_found.y, expected_centre.y, 1e-2, label + ": centre y");
+        checkNear(radius_found, expected_radius, 1e-2, label + ": radius");
+        check(blob.bounds == cv::boundingRect(contour), label + ": blob bounds");
+    }
+}
+
+// Function to check that the tiled mask of buildDetectionMaskTiled is the untiled one for tile heights
+// that divide the frame or not, down to tiles shorter than the halo, and for every morphology iteration
+// count including none
+void checkTiling() {
+    std::mt19937 rng(7);
+    DetectionParams params;
+    for (cv::Size size : {cv::Size(333, 97), cv::Size(641, 256), cv::Size(130, 301)}) {
+        // Noisy background, the frame adds pink discs and noise that straddles the color and gray thresholds
+        cv::Mat background(size, CV_8UC3), noise(size, CV_8UC3);
+        cv::randu(background, cv::Scalar::all(0), cv::Scalar::all(120));
+        cv::Mat frame = background.clone();
+        for (int i = 0; i < 12; ++i) {
+            cv::Point centre(std::uniform_int_distribution<int>(0, size.width - 1)(rng),
+                             std::uniform_int_distribution<int>(0, size.height - 1)(rng));
+            cv::circle(frame, centre, std::uniform_int_distribution<int>(2, 25)(rng), cv::Scalar(200, 40, 220),
+                       cv::FILLED);
+        }
+        cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(60));
+        cv::add(frame, noise, frame);
+
+        for (int iterations : {0, 1, 2, 3}) {
+            params.morphology_iterations = iterations;
+            BitMaskWorkspace untiled;
+            untiled.mask.create(frame.rows, frame.cols);
+            packDetectionMask(frame, background, params, untiled.mask, 0);
+            closeBitMask(untiled.mask, untiled.scratch, iterations);
+            check(untiled.mask.count() > 0, "tiling: empty detection mask");
+
+            for (int tile_rows : {1, 3, 8, 16, 33, 64, 128}) {
+                params.tile_rows = tile_rows;
+                BitMaskWorkspace tiled;
+                buildDetectionMaskTiled(frame, background, params, tiled);
+                check(tiled.mask.bits == untiled.mask.bits,
+                      "tiling: " + std::to_string(size.width) + "x" + std::to_string(size.height) + " frame, " +
+                          std::to_string(tile_rows) + " rows per tile, " + std::to_string(iterations) +
+                          " iterations differs from the untiled mask");
+            }
+        }
+    }
+}
+
+// Tests of the bit packed detection mask against the 8 bit OpenCV stages it replaced: the morphology,
+// the ball's enclosing circle and the tiled mask construction
+int main() {
+    checkMorphology();
+    checkBlobs();
+    checkTiling();
+    return finishTests("bit_mask_test");
+}
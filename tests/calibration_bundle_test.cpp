@@ -0,0 +1,143 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "multi_camera_setup/calibration_bundle.h"
+#include "multi_camera_setup/camera_rig.h"
+#include "multi_camera_setup/utils.h"
+#include "test_utils.h"
+
+// Function to make a calibration with one camera per distortion model: none, 4, 5 and 8 coefficients
+std::vector<CameraData> makeCalibration() {
+    const std::vector<std::vector<double>> dists = {
+        {}, {-0.12, 0.05, 1e-3, -5e-4}, {-0.12, 0.05, 1e-3, -5e-4, -0.01},
+        {0.3, -0.05, 1e-3, -5e-4, 0.01, 0.45, -0.02, 0.005}};
+    std::vector<CameraData> cameras;
+    for (size_t i = 0; i < dists.size(); ++i) {
+        CameraData camera;
+        camera.name = "camera" + std::to_string(i + 1);
+        camera.tvec = {1.6 - 0.9 * i, -0.3 - 0.2 * i, -7.2 + 0.8 * i};
+        camera.rvec = {0.37 - 0.1 * i, -0.65 + 1.1 * i, -0.13 + 0.2 * i};
+        camera.K = {{834.06 + 10.0 * i, 0.0, 639.5}, {0.0, 834.06 + 12.0 * i, 511.5}, {0.0, 0.0, 1.0}};
+        camera.dist = dists[i];
+        cameras.push_back(camera);
+    }
+    return cameras;
+}
+
+// Function to read a whole file
+std::vector<char> readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Function to write bytes to a file
+void writeFile(const std::string& path, const std::vector<char>& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// Function to compile cameras.json, open the bundle and check that cameraData() and projectionMatrices()
+// equal what the JSON path gives: the parsed calibration and each Camera's getProjectionMatrix
+void checkRoundTrip(const std::string& jsonPath, const std::string& bundlePath) {
+    check(compileCalibrationBundle(jsonPath, bundlePath), "compile cameras.json");
+    std::vector<CameraData> expected = loadCameraParamsFromJson(jsonPath);
+
+    CalibrationBundle bundle;
+    if (!check(bundle.open(bundlePath), "open the compiled bundle")) {
+        return;
+    }
+    check(bundle.camerasNum() == expected.size(), "camera count");
+
+    std::vector<CameraData> actual = bundle.cameraData();
+    for (size_t i = 0; i < expected.size() && i < actual.size(); ++i) {
+        std::string label = expected[i].name;
+        check(actual[i].name == expected[i].name, label + ": name");
+        check(actual[i].tvec == expected[i].tvec, label + ": tvec");
+        check(actual[i].rvec == expected[i].rvec, label + ": rvec");
+        check(actual[i].K == expected[i].K, label + ": K");
+        check(actual[i].dist == expected[i].dist, label + ": dist");
+    }
+
+    // Same products of the same doubles, equal up to rounding
+    CameraRig rig(expected);
+    std::vector<cv::Mat> reference = getProjectionMatrices(rig.cameras);
+    std::vector<cv::Mat> projections = bundle.projectionMatrices();
+    for (size_t i = 0; i < reference.size() && i < projections.size(); ++i) {
+        double scale = cv::norm(reference[i], cv::NORM_INF);
+        checkNear(cv::norm(projections[i], reference[i], cv::NORM_INF) / scale, 0.0, 1e-14,
+                  expected[i].name + ": projection matrix");
+    }
+}
+
+// Function to check that open() rejects a damaged copy of a valid bundle
+void checkRejected(const std::string& path, const std::vector<char>& bytes, const std::string& label) {
+    writeFile(path, bytes);
+    CalibrationBundle bundle;
+    check(!bundle.open(path), label + " bundle is rejected");
+    check(!bundle.isOpen() && bundle.camerasNum() == 0, label + " bundle leaves the view closed");
+}
+
+// Tests of calibration_bundle.h: a compiled bundle must give back the calibration and the projection
+// matrices of the JSON path, and truncated, wrong magic, wrong version and inconsistent bundles must be
+// rejected when opened
+int main() {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "calibration_bundle_test";
+    std::filesystem::create_directories(dir);
+    std::string jsonPath = (dir / "cameras.json").string();
+    std::string bundlePath = (dir / "cameras.bundle").string();
+    std::string damagedPath = (dir / "damaged.bundle").string();
+
+    check(saveCameraParamsToJson(makeCalibration(), jsonPath), "write cameras.json");
+    checkRoundTrip(jsonPath, bundlePath);
+
+    const std::vector<char> valid = readFile(bundlePath);
+    check(valid.size() == sizeof(BundleHeader) + 4 * sizeof(BundleCamera), "bundle size");
+
+    checkRejected(damagedPath, std::vector<char>(), "empty");
+    checkRejected(damagedPath, std::vector<char>(valid.begin(), valid.begin() + sizeof(BundleHeader) / 2),
+                  "truncated header");
+    checkRejected(damagedPath, std::vector<char>(valid.begin(), valid.end() - sizeof(BundleCamera) / 2),
+                  "truncated camera record");
+
+    std::vector<char> damaged = valid;
+    damaged[0] = 'X';
+    checkRejected(damagedPath, damaged, "wrong magic");
+
+    damaged = valid;
+    uint32_t version = CALIBRATION_BUNDLE_VERSION - 1;
+    std::memcpy(damaged.data() + offsetof(BundleHeader, version), &version, sizeof(version));
+    checkRejected(damagedPath, damaged, "wrong version");
+
+    damaged = valid;
+    uint32_t byte_order = 0x04030201;
+    std::memcpy(damaged.data() + offsetof(BundleHeader, byte_order), &byte_order, sizeof(byte_order));
+    checkRejected(damagedPath, damaged, "swapped byte order");
+
+    damaged = valid;
+    uint32_t cameras_num = 5;
+    std::memcpy(damaged.data() + offsetof(BundleHeader, cameras_num), &cameras_num, sizeof(cameras_num));
+    checkRejected(damagedPath, damaged, "wrong camera count");
+
+    damaged = valid;
+    damaged[sizeof(BundleHeader) + sizeof(BundleCamera::name) - 1] = 'x';
+    checkRejected(damagedPath, damaged, "unterminated name");
+
+    // The JSON validation refuses to compile a broken calibration and leaves no bundle behind
+    std::vector<CameraData> broken = makeCalibration();
+    broken[1].K[0][0] = 0.0;
+    broken[2].name = broken[0].name;
+    std::string brokenJson = (dir / "broken.json").string();
+    std::string brokenBundle = (dir / "broken.bundle").string();
+    std::filesystem::remove(brokenBundle);
+    check(saveCameraParamsToJson(broken, brokenJson), "write broken cameras.json");
+    check(!compileCalibrationBundle(brokenJson, brokenBundle), "broken calibration is not compiled");
+    check(!std::filesystem::exists(brokenBundle), "broken calibration writes no bundle");
+
+    std::filesystem::remove_all(dir);
+    return finishTests("calibration_bundle_test");
+}
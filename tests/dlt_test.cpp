@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "multi_camera_setup/dlt.h"
+#include "test_utils.h"
+
+// Reference DLT through cv::SVD on the full 2N x 4 system, the triangulation the kernels replaced
+cv::Point3d triangulatePointSvd(const std::vector<cv::Matx34d>& projections, const std::vector<cv::Point2d>& points,
+                                cv::Vec4d& singular_values) {
+    cv::Mat A(2 * static_cast<int>(projections.size()), 4, CV_64F);
+    for (int i = 0; i < static_cast<int>(projections.size()); ++i) {
+        for (int c = 0; c < 4; ++c) {
+            A.at<double>(2 * i, c) = points[i].x * projections[i](2, c) - projections[i](0, c);
+            A.at<double>(2 * i + 1, c) = points[i].y * projections[i](2, c) - projections[i](1, c);
+        }
+    }
+    cv::Mat w, u, vt;
+    cv::SVD::compute(A, w, u, vt);
+    for (int j = 0; j < 4; ++j) {
+        singular_values[j] = w.at<double>(j);
+    }
+    return cv::Point3d(vt.at<double>(3, 0) / vt.at<double>(3, 3), vt.at<double>(3, 1) / vt.at<double>(3, 3),
+                       vt.at<double>(3, 2) / vt.at<double>(3, 3));
+}
+
+// Rig layouts, from a wide ring to the near degenerate ones where the DLT is badly conditioned
+enum class RigLayout { Ring, SmallBaseline, Collinear };
+
+const char* layoutName(RigLayout layout) {
+    switch (layout) {
+    case RigLayout::Ring: return "ring";
+    case RigLayout::SmallBaseline: return "small baseline";
+    default: return "collinear";
+    }
+}
+
+// Function to build a pinhole camera at centre looking at target, with the image y axis pointing down
+cv::Matx34d lookAt(const cv::Vec3d& centre, const cv::Vec3d& target, double focal) {
+    cv::Vec3d forward = cv::normalize(target - centre);
+    cv::Vec3d right = cv::normalize(forward.cross(cv::Vec3d(0, 1, 0)));
+    cv::Vec3d down = forward.cross(right);
+    cv::Matx33d K(focal, 0, 640, 0, focal, 512, 0, 0, 1);
+    cv::Matx33d R(right[0], right[1], right[2], down[0], down[1], down[2], forward[0], forward[1], forward[2]);
+    cv::Matx33d KR = K * R;
+    cv::Vec3d t = -(KR * centre);
+    return cv::Matx34d(KR(0, 0), KR(0, 1), KR(0, 2), t[0],
+                       KR(1, 0), KR(1, 1), KR(1, 2), t[1],
+                       KR(2, 0), KR(2, 1), KR(2, 2), t[2]);
+}
+
+// Function to place cameras for a layout around a ball near the origin, in metres
+std::vector<cv::Matx34d> makeRig(RigLayout layout, size_t cameras, std::mt19937& rng) {
+    std::uniform_real_distribution<double> jitter(-0.1, 0.1);
+    std::vector<cv::Matx34d> rig;
+    for (size_t i = 0; i < cameras; ++i) {
+        double angle = 2.0 * CV_PI * i / cameras;
+        cv::Vec3d centre;
+        if (layout == RigLayout::Ring) {
+            centre = cv::Vec3d(4.0 * std::cos(angle), 1.5 + jitter(rng), 4.0 * std::sin(angle));
+        } else if (layout == RigLayout::SmallBaseline) {
+            // Cameras within a few millimetres of each other, 5 m from the ball
+            centre = cv::Vec3d(0.005 * std::cos(angle), 1.0 + 0.005 * std::sin(angle), -5.0);
+        } else {
+            // Cameras on a line that passes a millimetre from the ball
+            centre = cv::Vec3d(-3.0 - 0.5 * i, 0.001, 0.0);
+        }
+        cv::Vec3d target(jitter(rng), jitter(rng), jitter(rng));
+        rig.push_back(lookAt(centre, target, 1000.0 + 1000.0 * jitter(rng)));
+    }
+    return rig;
+}
+
+// Worst deviation from the cv::SVD reference over the trials of one camera count and layout. Point errors
+// are scaled by the reference's conditioning: the null vector of a perturbed A moves by about
+// eps * sigma_0 / (sigma_2 - sigma_3), so any two correct solvers may differ by that much.
+struct DltDeviation {
+    double point = 0.0; // Point difference over the conditioning bound
+    double singular_values = 0.0; // Singular value difference relative to the largest one
+    double fixed_dynamic = 0.0; // Point difference between the fixed and dynamic kernels, same scaling
+};
+
+template <size_t N>
+DltDeviation compareKernels(RigLayout layout, int trials) {
+    std::mt19937 rng(static_cast<unsigned>(N * 31 + static_cast<int>(layout)));
+    std::normal_distribution<double> pixel_noise(0.0, 0.5);
+    std::uniform_real_distribution<double> position(-0.2, 0.2);
+    DltDeviation deviation;
+    for (int trial = 0; trial < trials; ++trial) {
+        std::vector<cv::Matx34d> projections = makeRig(layout, N, rng);
+        cv::Vec4d ball(position(rng), position(rng), position(rng), 1.0);
+        std::vector<cv::Point2d> points;
+        for (const cv::Matx34d& P : projections) {
+            cv::Vec3d h = P * ball;
+            points.emplace_back(h[0] / h[2] + pixel_noise(rng), h[1] / h[2] + pixel_noise(rng));
+        }
+
+        cv::Vec4d reference_values, fixed_values, dynamic_values;
+        cv::Point3d reference = triangulatePointSvd(projections, points, reference_values);
+        cv::Point3d fixed = triangulateDltFixed<N>(projections.data(), points.data(), N, fixed_values);
+        cv::Point3d dynamic = triangulateDltDynamic(projections.data(), points.data(), N, dynamic_values);
+
+        double gap = std::max(reference_values[2] - reference_values[3], 1e-300);
+        double scale = DBL_EPSILON * reference_values[0] / gap * (1.0 + cv::norm(reference) * cv::norm(reference));
+        deviation.point = std::max(deviation.point, cv::norm(fixed - reference) / scale);
+        deviation.fixed_dynamic = std::max(deviation.fixed_dynamic, cv::norm(fixed - dynamic) / scale);
+        for (int j = 0; j < 4; ++j) {
+            double difference = std::max(std::abs(fixed_values[j] - reference_values[j]),
+                                         std::abs(dynamic_values[j] - reference_values[j]));
+            deviation.singular_values = std::max(deviation.singular_values, difference / reference_values[0]);
+        }
+    }
+    return deviation;
+}
+
+// Function to check triangulateDltFixed<N> and triangulateDltDynamic against cv::SVD for N = 2 + Ns.
+// Against a long double reference the points stayed within 0.25 of the bound. cv::SVD itself is off by
+// up to 36 times the bound on ring rigs of 13 cameras or more (LAPACK's SVD is on every ring rig), so
+// the point tolerance is about three times that. Singular values stayed within 2e-15 of the largest one.
+template <size_t... Ns>
+void checkCameraCounts(std::index_sequence<Ns...>, int trials) {
+    const size_t counts[] = {(Ns + 2)...};
+    for (RigLayout layout : {RigLayout::Ring, RigLayout::SmallBaseline, RigLayout::Collinear}) {
+        DltDeviation deviations[] = {compareKernels<Ns + 2>(layout, trials)...};
+        for (size_t k = 0; k < sizeof...(Ns); ++k) {
+            std::string label = std::to_string(counts[k]) + " cameras, " + layoutName(layout);
+            checkNear(deviations[k].point, 0.0, 100.0, label + ": point against cv::SVD");
+            checkNear(deviations[k].fixed_dynamic, 0.0, 10.0, label + ": fixed against dynamic kernel");
+            checkNear(deviations[k].singular_values, 0.0, 1e-13, label + ": singular values against cv::SVD");
+        }
+    }
+}
+
+// Tests of the DLT kernels of dlt.h: the fixed size kernel for every camera count from 2 to 17 and the
+// dynamic one must give the point and singular values of the cv::SVD DLT on noisy observations, on a wide
+// rig as well as on small baseline and collinear rigs.
+// Usage: dlt_test [trials]
+int main(int argc, char** argv) {
+    int trials = argc > 1 ? std::stoi(argv[1]) : 200;
+    checkCameraCounts(std::make_index_sequence<16>(), trials);
+    return finishTests("dlt_test");
+}
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <opencv2/opencv.hpp>
+#include "multi_camera_setup/fixed_kalman.h"
+#include "test_utils.h"
+
+// Function to get the largest difference between a cv::Matx and a cv::Mat of the same shape, relative to
+// the largest element of the reference
+template <typename T, int Rows, int Cols>
+double relativeDeviation(const cv::Matx<T, Rows, Cols>& actual, const cv::Mat& reference) {
+    cv::Mat expected;
+    reference.convertTo(expected, CV_64F);
+    double deviation = 0.0;
+    double scale = std::max(cv::norm(expected, cv::NORM_INF), 1e-12);
+    for (int i = 0; i < Rows; ++i) {
+        for (int j = 0; j < Cols; ++j) {
+            deviation = std::max(deviation, std::abs(static_cast<double>(actual(i, j)) - expected.at<double>(i, j)));
+        }
+    }
+    return deviation / scale;
+}
+
+// Function to copy a cv::Matx into a cv::Mat of the filter's type
+template <typename T, int Rows, int Cols>
+cv::Mat toMat(const cv::Matx<T, Rows, Cols>& matrix) {
+    return cv::Mat(Rows, Cols, cv::DataType<T>::depth, const_cast<T*>(matrix.val)).clone();
+}
+
+// Function to run FixedKalmanFilter and cv::KalmanFilter through the same constant velocity sequence:
+// a noisy track in Dim dimensions, measurements with a per call noise and every fifth one missing. Returns
+// the worst relative deviation of the state and the covariance over the sequence.
+template <int Dim, typename T>
+double compareFilters(int steps, unsigned seed) {
+    typedef FixedKalmanFilter<2 * Dim, Dim, T> Filter;
+    const int type = cv::DataType<T>::depth;
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::uniform_real_distribution<double> variance(0.01, 4.0);
+
+    Filter fixed;
+    cv::KalmanFilter reference(2 * Dim, Dim, 0, type);
+    for (int i = 0; i < Dim; ++i) {
+        fixed.transition(i, i + Dim) = static_cast<T>(1);
+        fixed.measurement_matrix(i, i) = static_cast<T>(1);
+    }
+    fixed.process_noise = Filter::StateMat::eye() * static_cast<T>(1e-2);
+    fixed.measurement_noise = Filter::MeasMat::eye() * static_cast<T>(0.5);
+    fixed.covariance = Filter::StateMat::eye() * static_cast<T>(10);
+    for (int i = 0; i < Dim; ++i) {
+        fixed.state(i) = static_cast<T>(100.0 * (i + 1));
+    }
+    reference.transitionMatrix = toMat(fixed.transition);
+    reference.measurementMatrix = toMat(fixed.measurement_matrix);
+    reference.processNoiseCov = toMat(fixed.process_noise);
+    reference.measurementNoiseCov = toMat(fixed.measurement_noise);
+    reference.errorCovPost = toMat(fixed.covariance);
+    reference.statePost = toMat(fixed.state);
+
+    double position[Dim];
+    double velocity[Dim];
+    for (int i = 0; i < Dim; ++i) {
+        position[i] = 100.0 * (i + 1);
+        velocity[i] = 2.0 + i;
+    }
+
+    double deviation = 0.0;
+    for (int step = 0; step < steps; ++step) {
+        fixed.predict();
+        reference.predict();
+        deviation = std::max(deviation, relativeDeviation(fixed.state, reference.statePre));
+        deviation = std::max(deviation, relativeDeviation(fixed.covariance, reference.errorCovPre));
+
+        typename Filter::MeasVec measurement;
+        for (int i = 0; i < Dim; ++i) {
+            velocity[i] += 0.1 * noise(rng);
+            position[i] += velocity[i];
+            measurement(i) = static_cast<T>(position[i] + noise(rng));
+        }
+        if (step % 5 == 4) {
+            continue;
+        }
+
+        // Every other measurement comes with its own noise, the way flow and detection are fused
+        if (step % 2 == 0) {
+            fixed.correct(measurement);
+        } else {
+            typename Filter::MeasMat measurement_noise = Filter::MeasMat::eye() * static_cast<T>(variance(rng));
+            reference.measurementNoiseCov = toMat(measurement_noise);
+            fixed.correct(measurement, measurement_noise);
+        }
+        reference.correct(toMat(measurement));
+        reference.measurementNoiseCov = toMat(fixed.measurement_noise);
+        deviation = std::max(deviation, relativeDeviation(fixed.state, reference.statePost));
+        deviation = std::max(deviation, relativeDeviation(fixed.covariance, reference.errorCovPost));
+    }
+    return deviation;
+}
+
+// Tests of FixedKalmanFilter (fixed_kalman.h) against cv::KalmanFilter on the same sequences, in the
+// shapes the pipeline uses: the per camera 2D float filter and the 3D double filter of the smoother
+// Usage: fixed_kalman_test [steps]
+int main(int argc, char** argv) {
+    int steps = argc > 1 ? std::stoi(argv[1]) : 500;
+    // The float filters round in a different order, a few hundred ulps that do not grow with the sequence
+    for (unsigned seed = 1; seed <= 4; ++seed) {
+        std::string label = "seed " + std::to_string(seed);
+        checkNear(compareFilters<2, float>(steps, seed), 0.0, 2e-4, label + ": 4x2 float filter");
+        checkNear(compareFilters<3, double>(steps, seed), 0.0, 1e-12, label + ": 6x3 double filter");
+    }
+    return finishTests("fixed_kalman_test");
+}
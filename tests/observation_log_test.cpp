@@ -0,0 +1,148 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "multi_camera_setup/observation_log.h"
+#include "test_utils.h"
+
+// Function to fill the track states of one frame with values that differ per frame and camera, every
+// third camera without a measurement
+std::vector<CameraTrackState> makeStates(size_t cameras_num, size_t frame_index) {
+    const TrackerMode modes[] = {TrackerMode::FullDetection, TrackerMode::RoiDetection, TrackerMode::OpticalFlow,
+                                 TrackerMode::CorrelationFilter, TrackerMode::PredictOnly};
+    const uint8_t flags[] = {MeasuredByDetection, MeasuredByFlow, MeasuredByCorrelation,
+                             MeasuredByDetection | MeasuredByFlow};
+    std::vector<CameraTrackState> states(cameras_num);
+    for (size_t i = 0; i < cameras_num; ++i) {
+        size_t n = frame_index * cameras_num + i;
+        CameraTrackState& state = states[i];
+        state.undistorted_position = cv::Point2d(100.0 + 0.123456789 * n, 900.0 - 1.0 / (n + 3.0));
+        state.is_detection_valid = n % 3 != 2;
+        state.tracker_radius = state.is_detection_valid ? 4.0f + 0.25f * (n % 7) : 0.0f;
+        state.blob_area = state.is_detection_valid ? 50.0f + 1.5f * (n % 11) : 0.0f;
+        state.measurement_flags = state.is_detection_valid ? flags[n % 4] : 0;
+        state.tracker_mode = modes[n % 5];
+    }
+    return states;
+}
+
+// Function to check that restore() gives back the states a frame was written from
+void checkFrame(const ObservationLog& log, size_t frame_index, const std::string& label) {
+    std::vector<CameraTrackState> expected = makeStates(log.camerasNum(), frame_index);
+    std::vector<CameraTrackState> actual(log.camerasNum());
+    log.restore(frame_index, actual);
+    bool same = true;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        same = same && actual[i].undistorted_position == expected[i].undistorted_position &&
+               actual[i].tracker_radius == expected[i].tracker_radius &&
+               actual[i].blob_area == expected[i].blob_area &&
+               actual[i].is_detection_valid == expected[i].is_detection_valid &&
+               actual[i].measurement_flags == expected[i].measurement_flags &&
+               actual[i].tracker_mode == expected[i].tracker_mode;
+    }
+    check(same, label + ": frame " + std::to_string(frame_index) + " restores as written");
+}
+
+// Function to read a whole file
+std::vector<char> readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Function to write bytes to a file
+void writeFile(const std::string& path, const std::vector<char>& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// Function to check that open() rejects a damaged copy of a valid log
+void checkRejected(const std::string& path, const std::vector<char>& bytes, const std::string& label) {
+    writeFile(path, bytes);
+    ObservationLog log;
+    check(!log.open(path), label + " log is rejected");
+    check(!log.isOpen() && log.camerasNum() == 0, label + " log leaves the view closed");
+}
+
+// Tests of observation_log.h: a written log must open with its camera count, fps and frame count and
+// restore every frame as written; a log cut short inside a frame must replay up to its last complete
+// frame; truncated header, wrong magic, wrong version and swapped byte order logs must be rejected
+int main() {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "observation_log_test";
+    std::filesystem::create_directories(dir);
+    std::string logPath = (dir / "observations.bin").string();
+    std::string damagedPath = (dir / "damaged.bin").string();
+    const size_t cameras_num = 5;
+    const size_t frames_num = 40;
+    const double fps = 120.0;
+
+    ObservationLogWriter writer;
+    check(writer.open(logPath, cameras_num, fps), "open the writer");
+    for (size_t frame = 0; frame < frames_num; ++frame) {
+        writer.write(makeStates(cameras_num, frame));
+    }
+    writer.close();
+
+    const std::vector<char> valid = readFile(logPath);
+    const size_t frame_size = cameras_num * sizeof(ObservationRecord);
+    check(valid.size() == sizeof(ObservationLogHeader) + frames_num * frame_size, "log size");
+
+    {
+        ObservationLog log;
+        if (check(log.open(logPath), "open the written log")) {
+            check(log.camerasNum() == cameras_num, "camera count");
+            check(log.framesNum() == frames_num, "frame count");
+            check(log.fps() == fps, "fps");
+            for (size_t frame = 0; frame < frames_num; ++frame) {
+                checkFrame(log, frame, "complete log");
+            }
+        }
+    }
+
+    // Cut inside the last frame, in the middle of a record and on a record boundary: the partial frame is
+    // not replayed, the complete ones are
+    for (size_t cut : {frame_size / 2 + 3, sizeof(ObservationRecord), frame_size - sizeof(ObservationRecord)}) {
+        std::string label = "log cut " + std::to_string(cut) + " bytes short";
+        writeFile(damagedPath, std::vector<char>(valid.begin(), valid.end() - cut));
+        ObservationLog log;
+        if (check(log.open(damagedPath), label + " opens")) {
+            check(log.framesNum() == frames_num - 1, label + ": frame count");
+            checkFrame(log, 0, label);
+            checkFrame(log, frames_num - 2, label);
+        }
+    }
+    {
+        writeFile(damagedPath, std::vector<char>(valid.begin(), valid.begin() + sizeof(ObservationLogHeader)));
+        ObservationLog log;
+        check(log.open(damagedPath) && log.framesNum() == 0, "log with a header only opens with no frames");
+    }
+
+    checkRejected(damagedPath, std::vector<char>(), "empty");
+    checkRejected(damagedPath, std::vector<char>(valid.begin(), valid.begin() + sizeof(ObservationLogHeader) / 2),
+                  "truncated header");
+
+    std::vector<char> damaged = valid;
+    damaged[0] = 'X';
+    checkRejected(damagedPath, damaged, "wrong magic");
+
+    damaged = valid;
+    uint32_t version = OBSERVATION_LOG_VERSION + 1;
+    std::memcpy(damaged.data() + offsetof(ObservationLogHeader, version), &version, sizeof(version));
+    checkRejected(damagedPath, damaged, "wrong version");
+
+    damaged = valid;
+    uint32_t byte_order = 0x04030201;
+    std::memcpy(damaged.data() + offsetof(ObservationLogHeader, byte_order), &byte_order, sizeof(byte_order));
+    checkRejected(damagedPath, damaged, "swapped byte order");
+
+    damaged = valid;
+    uint32_t no_cameras = 0;
+    std::memcpy(damaged.data() + offsetof(ObservationLogHeader, cameras_num), &no_cameras, sizeof(no_cameras));
+    checkRejected(damagedPath, damaged, "no cameras");
+
+    std::filesystem::remove_all(dir);
+    return finishTests("observation_log_test");
+}
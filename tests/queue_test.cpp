@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "multi_camera_setup/ring_queue.h"
+#include "test_utils.h"
+
+// Item tagged with its producer and its position in that producer's stream
+struct StressItem {
+    uint32_t producer = 0;
+    uint64_t sequence = 0;
+};
+
+// Function to stream items_per_producer items from each producer in push_batch sized batches while the
+// consumer pops up to pop_batch at a time. Checks that every item arrives exactly once and in its
+// producer's order, then that the closed and drained queue reports the end of the stream.
+template <typename Queue>
+void checkTransfer(const std::string& name, size_t capacity, int producers, size_t items_per_producer,
+                   size_t push_batch, size_t pop_batch) {
+    Queue queue(capacity);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            std::vector<StressItem> items(push_batch);
+            for (size_t sent = 0; sent < items_per_producer; sent += push_batch) {
+                size_t count = std::min(push_batch, items_per_producer - sent);
+                for (size_t i = 0; i < count; ++i) {
+                    items[i].producer = static_cast<uint32_t>(p);
+                    items[i].sequence = sent + i;
+                }
+                queue.pushBatch(items.data(), count);
+            }
+        });
+    }
+
+    std::vector<uint64_t> expected(producers, 0);
+    std::vector<StressItem> received(pop_batch);
+    size_t total = 0;
+    bool ordered = true;
+    while (total < items_per_producer * producers) {
+        size_t popped = queue.popBatch(received.data(), pop_batch);
+        for (size_t i = 0; i < popped; ++i) {
+            const StressItem& item = received[i];
+            if (item.producer >= static_cast<uint32_t>(producers) || item.sequence != expected[item.producer]) {
+                ordered = false;
+            } else {
+                expected[item.producer]++;
+            }
+        }
+        total += popped;
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::string label = name + " (capacity " + std::to_string(capacity) + ", " + std::to_string(producers) +
+                        " producers, push " + std::to_string(push_batch) + ", pop " + std::to_string(pop_batch) + ")";
+    check(ordered, label + ": items lost, duplicated or reordered");
+    for (int p = 0; p < producers; ++p) {
+        check(expected[p] == items_per_producer, label + ": producer " + std::to_string(p) + " delivered " +
+                                                     std::to_string(expected[p]) + " items");
+    }
+    queue.close();
+    check(queue.popBatch(received.data(), pop_batch) == 0, label + ": pop after close and drain returned items");
+}
+
+template <typename Queue>
+void checkAllTransfers(const std::string& name, int producers, size_t items_per_producer) {
+    for (size_t capacity : {size_t(2), size_t(3), size_t(64), size_t(1024)}) {
+        for (size_t push_batch : {size_t(1), size_t(7), size_t(64)}) {
+            for (size_t pop_batch : {size_t(1), size_t(16)}) {
+                checkTransfer<Queue>(name, capacity, producers, items_per_producer, push_batch, pop_batch);
+            }
+        }
+    }
+}
+
+// Function to check the non blocking calls and close on one thread
+template <typename Queue>
+void checkBounds(const std::string& name) {
+    Queue queue(3);
+    check(queue.capacity() == 4, name + ": capacity 3 not rounded up to 4");
+    for (uint64_t i = 0; i < 4; ++i) {
+        check(queue.tryPush(StressItem{0, i}), name + ": push into a queue with space failed");
+    }
+    check(!queue.tryPush(StressItem{0, 4}), name + ": push into a full queue succeeded");
+    check(queue.sizeApprox() == 4, name + ": full queue size");
+
+    StressItem item;
+    check(queue.tryPop(item) && item.sequence == 0, name + ": first pop");
+    check(queue.tryPush(StressItem{0, 4}), name + ": push after a pop failed");
+
+    // A producer blocked on the full queue gives up when it is closed, the consumer still drains it
+    std::thread blocked([&]() {
+        check(!queue.push(StressItem{0, 5}), name + ": push into a closed full queue succeeded");
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.close();
+    blocked.join();
+    uint64_t next = 1;
+    while (queue.pop(item)) {
+        check(item.sequence == next++, name + ": drain after close out of order");
+    }
+    check(next == 5, name + ": drain after close lost items");
+    check(!queue.tryPop(item), name + ": pop from a drained queue");
+}
+
+// Stress test of the stage hand-off rings of ring_queue.h: no lost, duplicated or reordered items for
+// every ring, wait policy, capacity (including ones smaller than a batch) and batch size. Worth running
+// in a -fsanitize=thread build too.
+// Usage: queue_test [items per producer]
+int main(int argc, char** argv) {
+    size_t items = argc > 1 ? std::stoul(argv[1]) : 8000;
+
+    checkBounds<SpscQueue<StressItem, SpinWaitPolicy>>("SpscQueue spin");
+    checkBounds<SpscQueue<StressItem, BlockingWaitPolicy>>("SpscQueue blocking");
+    checkBounds<MpscQueue<StressItem, SpinWaitPolicy>>("MpscQueue spin");
+    checkBounds<MpscQueue<StressItem, BlockingWaitPolicy>>("MpscQueue blocking");
+
+    checkAllTransfers<SpscQueue<StressItem, SpinWaitPolicy>>("SpscQueue spin", 1, items);
+    checkAllTransfers<SpscQueue<StressItem, BlockingWaitPolicy>>("SpscQueue blocking", 1, items);
+    checkAllTransfers<MpscQueue<StressItem, SpinWaitPolicy>>("MpscQueue spin", 4, items / 4);
+    checkAllTransfers<MpscQueue<StressItem, BlockingWaitPolicy>>("MpscQueue blocking", 4, items / 4);
+    return finishTests("queue_test");
+}
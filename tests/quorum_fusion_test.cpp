@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "multi_camera_setup/quorum_fusion.h"
+#include "test_utils.h"
+
+// Function to build a rig of cameras on a line, alternately raised, all looking down the z axis at the
+// throw
+std::vector<cv::Mat> makeRig(int cameras) {
+    std::vector<cv::Mat> rig;
+    for (int i = 0; i < cameras; ++i) {
+        cv::Matx34d P(1000, 0, 640, 1000 * (i - 0.5 * (cameras - 1)),
+                      0, 1000, 512, 300 * (i % 2),
+                      0, 0, 1, 5);
+        rig.push_back(cv::Mat(P));
+    }
+    return rig;
+}
+
+// Position of the ball in frame f
+cv::Point3d groundTruth(int frame) {
+    return cv::Point3d(0.01 * frame, 0.2 + 0.001 * frame, 1.0);
+}
+
+cv::Point2d project(const cv::Matx34d& P, const cv::Point3d& X) {
+    cv::Vec3d h = P * cv::Vec4d(X.x, X.y, X.z, 1.0);
+    return cv::Point2d(h[0] / h[2], h[1] / h[2]);
+}
+
+// Camera i misses the ball in every seventh frame, staggered across cameras
+bool isValid(int frame, int camera) {
+    return (frame + camera) % 7 != 0;
+}
+
+// Function to run camera threads against one fusion the way processQuorumCameraFrames does: each camera
+// waits for the window, reports its frames in order through an MpscQueue and the last camera stalls now
+// and then. Checks that both sinks see every frame once and in order, that a frame is fused no later than
+// it completes, that no camera runs more than window - 1 frames ahead and that the fused points match.
+void checkThreadedFusion(int cameras, int quorum, int window, int frames) {
+    std::string label = std::to_string(cameras) + " cameras, quorum " + std::to_string(quorum) + ", window " +
+                        std::to_string(window);
+    CameraGeometryBlock rig;
+    rig.setProjectionMatrices(makeRig(cameras));
+    QuorumConfig config;
+    config.quorum = quorum;
+    config.window = window;
+
+    int next_quorum = 0;
+    int next_complete = 0;
+    bool quorum_ordered = true;
+    bool complete_ordered = true;
+    bool complete_before_quorum = false;
+    bool complete_flags = true;
+    double max_error = 0.0;
+    QuorumFusion fusion(
+        rig, config,
+        [&](int frame, const CameraGeometryBlock& observations) {
+            quorum_ordered = quorum_ordered && frame == next_quorum;
+            next_quorum = frame + 1;
+            cv::Point3d error = triangulateValidObservations(observations) - groundTruth(frame);
+            max_error = std::max(max_error, cv::norm(error));
+        },
+        [&](int frame, const CameraGeometryBlock& observations) {
+            complete_ordered = complete_ordered && frame == next_complete;
+            complete_before_quorum = complete_before_quorum || frame >= next_quorum;
+            next_complete = frame + 1;
+            for (int i = 0; i < cameras; ++i) {
+                complete_flags = complete_flags && (observations.valid[i] != 0) == isValid(frame, i);
+            }
+        });
+
+    MpscQueue<CameraObservation, BlockingWaitPolicy> observations(cameras * fusion.windowSize());
+    std::atomic<int> max_ahead{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < cameras; ++i) {
+        threads.emplace_back([&, i]() {
+            std::mt19937 rng(i);
+            for (int frame = 0; frame < frames; ++frame) {
+                fusion.waitForWindow(frame);
+                int ahead = frame - fusion.completedFrames();
+                int previous = max_ahead.load();
+                while (ahead > previous && !max_ahead.compare_exchange_weak(previous, ahead)) {
+                }
+                if (i == cameras - 1 && rng() % 5 == 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                }
+                CameraObservation observation;
+                observation.frame = frame;
+                observation.camera = i;
+                observation.valid = isValid(frame, i) ? 1 : 0;
+                // A lost camera reports stale or empty points that must not reach the fused point
+                observation.point = observation.valid ? project(rig.projections[i], groundTruth(frame))
+                                                      : cv::Point2d(frame % 2 ? 0.0 : 5000.0, 0.0);
+                observations.push(observation);
+            }
+        });
+    }
+
+    std::vector<CameraObservation> batch(64);
+    while (fusion.completedFrames() < frames) {
+        size_t count = observations.popBatch(batch.data(), batch.size());
+        for (size_t k = 0; k < count; ++k) {
+            fusion.add(batch[k]);
+        }
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    check(quorum_ordered && next_quorum == frames, label + ": quorum sink missed or reordered frames");
+    check(complete_ordered && next_complete == frames, label + ": complete sink missed or reordered frames");
+    check(!complete_before_quorum, label + ": a frame completed before it was fused");
+    check(complete_flags, label + ": complete sink validity flags");
+    check(max_ahead.load() <= fusion.windowSize() - 1,
+          label + ": a camera ran " + std::to_string(max_ahead.load()) + " frames ahead");
+    checkNear(max_error, 0.0, 1e-6, label + ": fused point error");
+}
+
+// Function to feed observations by hand and check exactly when each sink fires: the quorum fires before
+// the last camera, a frame that reaches its quorum waits for an earlier one that has not, and a frame
+// whose valid observations never reach the quorum is fused once every camera reported.
+void checkFiringOrder() {
+    CameraGeometryBlock rig;
+    rig.setProjectionMatrices(makeRig(3));
+    QuorumConfig config;
+    config.quorum = 2;
+    config.window = 3;
+    std::vector<int> fused;
+    std::vector<int> completed;
+    std::vector<int> fused_valid;
+    QuorumFusion fusion(
+        rig, config,
+        [&](int frame, const CameraGeometryBlock& observations) {
+            fused.push_back(frame);
+            fused_valid.push_back(static_cast<int>(std::count(observations.valid.begin(), observations.valid.end(), 1)));
+        },
+        [&](int frame, const CameraGeometryBlock&) { completed.push_back(frame); });
+    auto add = [&](int frame, int camera, bool valid) {
+        CameraObservation observation;
+        observation.frame = frame;
+        observation.camera = camera;
+        observation.point = project(rig.projections[camera], groundTruth(frame));
+        observation.valid = valid ? 1 : 0;
+        fusion.add(observation);
+    };
+
+    check(fusion.quorumSize() == 2, "firing order: quorum size");
+    add(0, 0, true);
+    check(fused.empty(), "firing order: fused below the quorum");
+    add(0, 1, true);
+    check(fused == std::vector<int>{0} && completed.empty(), "firing order: quorum did not fire before the last camera");
+    check(fused_valid == std::vector<int>{2}, "firing order: cameras that have not reported are not marked invalid");
+
+    // Frame 1 is short of valid observations, frame 2 reaches its quorum first and must wait for it
+    add(1, 0, true);
+    add(1, 1, false);
+    add(2, 0, true);
+    add(2, 1, true);
+    check(fused == std::vector<int>{0}, "firing order: frame 2 fused ahead of frame 1");
+    add(0, 2, true);
+    check(completed == std::vector<int>{0} && fusion.completedFrames() == 1, "firing order: frame 0 not completed");
+    add(1, 2, false);
+    check(fused == (std::vector<int>{0, 1, 2}), "firing order: frames 1 and 2 not fused in order once 1 completed");
+    check(fused_valid == (std::vector<int>{2, 1, 2}), "firing order: valid observations handed to the sink");
+    check(completed == (std::vector<int>{0, 1}), "firing order: frame 1 not completed");
+    add(2, 2, true);
+    check(completed == (std::vector<int>{0, 1, 2}) && fused.size() == 3, "firing order: late camera fused frame 2 again");
+    check(fusion.completedFrames() == 3, "firing order: completed frame count");
+}
+
+// Tests of the quorum fusion driven directly with stub sinks: the firing rules on a hand fed sequence,
+// then camera threads with a slow camera for several rigs, quorums and windows. Worth running in a
+// -fsanitize=thread build too.
+// Usage: quorum_fusion_test [frames]
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::stoi(argv[1]) : 2000;
+
+    checkFiringOrder();
+    checkThreadedFusion(4, 3, 4, frames);
+    checkThreadedFusion(4, 4, 4, frames);
+    checkThreadedFusion(3, 2, 1, frames);
+    checkThreadedFusion(8, 5, 2, frames);
+    return finishTests("quorum_fusion_test");
+}
@@ -0,0 +1,120 @@
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "multi_camera_setup/stage_cache.h"
+#include "test_utils.h"
+
+// One change to the inputs of a cache key
+struct ConfigChange {
+    const char* name;
+    std::function<void(PipelineConfig&)> apply;
+};
+
+// Function to make a two camera calibration
+std::vector<CameraData> makeCalibration() {
+    std::vector<CameraData> cameras(2);
+    for (size_t i = 0; i < cameras.size(); ++i) {
+        cameras[i].name = "camera" + std::to_string(i + 1);
+        cameras[i].tvec = {1.6 - 0.9 * i, -0.3, -7.2};
+        cameras[i].rvec = {0.37, -0.65 + 1.1 * i, -0.13};
+        cameras[i].K = {{834.06, 0.0, 639.5}, {0.0, 834.06, 511.5}, {0.0, 0.0, 1.0}};
+        cameras[i].dist = {-0.12, 0.05, 1e-3, -5e-4};
+    }
+    return cameras;
+}
+
+// Tests of the stage cache keys (stage_cache.h): the observations key must change with every hashed
+// detection and fusion option, the inputs and the calibration, and not with options the trackers do not
+// read; the trajectory key must follow the observations key and the options after tracking
+int main() {
+    const uint64_t inputs = 0x0123456789abcdefull;
+    const std::vector<CameraData> calibration = makeCalibration();
+    PipelineConfig base;
+    base.detection_period = 3;
+    const uint64_t observations = observationsCacheKey(inputs, calibration, base);
+    check(observations == observationsCacheKey(inputs, calibration, base), "observations key is deterministic");
+
+    const std::vector<ConfigChange> hashed = {
+        {"detection_period", [](PipelineConfig& c) { c.detection_period = 4; }},
+        {"fusion.interframe_mode",
+         [](PipelineConfig& c) { c.fusion.interframe_mode = TrackerMode::CorrelationFilter; }},
+        {"fusion.detection_noise", [](PipelineConfig& c) { c.fusion.detection_noise *= 2.0f; }},
+        {"fusion.flow_noise", [](PipelineConfig& c) { c.fusion.flow_noise *= 2.0f; }},
+        {"fusion.correlation_noise", [](PipelineConfig& c) { c.fusion.correlation_noise *= 2.0f; }},
+        {"detection.hsv_lower[0]", [](PipelineConfig& c) { c.detection.hsv_lower[0] += 1.0; }},
+        {"detection.hsv_lower[2]", [](PipelineConfig& c) { c.detection.hsv_lower[2] += 1.0; }},
+        {"detection.hsv_upper[1]", [](PipelineConfig& c) { c.detection.hsv_upper[1] -= 1.0; }},
+        {"detection.background_threshold", [](PipelineConfig& c) { c.detection.background_threshold += 0.5; }},
+        {"detection.morphology_iterations", [](PipelineConfig& c) { c.detection.morphology_iterations += 1; }},
+        {"detection.area_threshold", [](PipelineConfig& c) { c.detection.area_threshold += 0.5f; }},
+        {"detection.flow_roi_size", [](PipelineConfig& c) { c.detection.flow_roi_size += 16; }},
+    };
+    for (const ConfigChange& change : hashed) {
+        PipelineConfig config = base;
+        change.apply(config);
+        check(observationsCacheKey(inputs, calibration, config) != observations,
+              std::string("observations key changes with ") + change.name);
+    }
+
+    // Same detection values in a different field must not collide, e.g. lower and upper swapped
+    PipelineConfig swapped = base;
+    swapped.detection.hsv_lower = base.detection.hsv_upper;
+    swapped.detection.hsv_upper = base.detection.hsv_lower;
+    check(observationsCacheKey(inputs, calibration, swapped) != observations,
+          "observations key changes with hsv_lower and hsv_upper swapped");
+
+    check(observationsCacheKey(inputs + 1, calibration, base) != observations,
+          "observations key changes with the inputs");
+    std::vector<CameraData> moved = calibration;
+    moved[1].tvec[2] += 1e-6;
+    check(observationsCacheKey(inputs, moved, base) != observations, "observations key changes with the calibration");
+
+    // Tiling does not change the mask, the display and the later stages do not change the observations
+    const std::vector<ConfigChange> unhashed = {
+        {"detection.tile_rows", [](PipelineConfig& c) { c.detection.tile_rows = 0; }},
+        {"display", [](PipelineConfig& c) { c.display = false; }},
+        {"use_world_tracker", [](PipelineConfig& c) { c.use_world_tracker = true; }},
+        {"smoother.lag", [](PipelineConfig& c) { c.smoother.lag += 1; }},
+    };
+    for (const ConfigChange& change : unhashed) {
+        PipelineConfig config = base;
+        change.apply(config);
+        check(observationsCacheKey(inputs, calibration, config) == observations,
+              std::string("observations key does not change with ") + change.name);
+    }
+
+    const uint64_t trajectory = trajectoryCacheKey(observations, base);
+    check(trajectory != observations, "trajectory key differs from the observations key");
+    check(trajectoryCacheKey(observations + 1, base) != trajectory, "trajectory key changes with the observations");
+
+    PipelineConfig tracked = base;
+    tracked.use_world_tracker = true;
+    const uint64_t tracked_key = trajectoryCacheKey(observations, tracked);
+    check(tracked_key != trajectory, "trajectory key changes with use_world_tracker");
+    PipelineConfig noisier = tracked;
+    noisier.world_tracker.pixel_noise *= 2.0;
+    check(trajectoryCacheKey(observations, noisier) != tracked_key,
+          "trajectory key changes with world_tracker.pixel_noise");
+    PipelineConfig gravity = tracked;
+    gravity.world_tracker.gravity[1] = -9.8;
+    check(trajectoryCacheKey(observations, gravity) != tracked_key,
+          "trajectory key changes with world_tracker.gravity");
+
+    // Options of stages that are off are not part of the key
+    PipelineConfig untracked = base;
+    untracked.world_tracker.pixel_noise *= 2.0;
+    untracked.smoother.lag += 1;
+    check(trajectoryCacheKey(observations, untracked) == trajectory,
+          "trajectory key ignores the world tracker and smoother options when they are off");
+    PipelineConfig smoothed = tracked;
+    smoothed.write_smoothed = true;
+    const uint64_t smoothed_key = trajectoryCacheKey(observations, smoothed);
+    check(smoothed_key != tracked_key, "trajectory key changes with write_smoothed");
+    smoothed.smoother.block_size *= 2;
+    check(trajectoryCacheKey(observations, smoothed) != smoothed_key,
+          "trajectory key changes with smoother.block_size");
+
+    return finishTests("stage_cache_test");
+}
@@ -0,0 +1,41 @@
+#ifndef TEST_UTILS_H
+#define TEST_UTILS_H
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Failed checks of the test executable so far
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+// Function to count a failed check and print its message, returns the condition
+inline bool check(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAILED: " << message << std::endl;
+        testFailures()++;
+    }
+    return condition;
+}
+
+// Function to check that two values are within tolerance of each other
+inline bool checkNear(double actual, double expected, double tolerance, const std::string& message) {
+    std::ostringstream stream;
+    stream << message << ": " << actual << " vs " << expected << " (tolerance " << tolerance << ")";
+    return check(std::abs(actual - expected) <= tolerance, stream.str());
+}
+
+// Function to end a test executable: print the result and return the exit code
+inline int finishTests(const std::string& name) {
+    if (testFailures() > 0) {
+        std::cerr << name << ": " << testFailures() << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << name << ": all checks passed" << std::endl;
+    return 0;
+}
+
+#endif // TEST_UTILS_H
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "multi_camera_setup/undistort.h"
+#include "test_utils.h"
+
+// Lens model under test, dist in the order PointUndistorter and OpenCV take it
+struct LensModel {
+    const char* name;
+    std::vector<double> dist;
+};
+
+// Worst deviations of PointUndistorter over the points of one model
+struct UndistortDeviation {
+    double opencv = 0.0; // Pixel difference to cv::undistortPoints
+    double round_trip = 0.0; // Pixel difference between the input and the undistorted point distorted again
+};
+
+// Function to get the test points: a grid over the image plus the pixels next to each corner and edge
+// centre, where the distortion is strongest
+std::vector<cv::Point2d> makeImagePoints(int width, int height) {
+    std::vector<cv::Point2d> points;
+    for (int y = 0; y <= 8; ++y) {
+        for (int x = 0; x <= 8; ++x) {
+            points.emplace_back((width - 1) * x / 8.0, (height - 1) * y / 8.0);
+        }
+    }
+    for (double inset : {0.5, 2.0, 10.0}) {
+        points.emplace_back(inset, inset);
+        points.emplace_back(width - 1 - inset, inset);
+        points.emplace_back(inset, height - 1 - inset);
+        points.emplace_back(width - 1 - inset, height - 1 - inset);
+        points.emplace_back(inset, height / 2.0);
+        points.emplace_back(width / 2.0, inset);
+    }
+    return points;
+}
+
+// Function to compare PointUndistorter against cv::undistortPoints with P = K for one lens model. OpenCV
+// stops after 5 iterations by default, short of convergence near the corners of strong lenses, so the
+// reference runs to convergence. The round trip through cv::projectPoints checks both against the model.
+UndistortDeviation compareUndistortion(const cv::Matx33d& K, const LensModel& model,
+                                       const std::vector<cv::Point2d>& points) {
+    std::vector<std::vector<double>> K_rows = {{K(0, 0), K(0, 1), K(0, 2)},
+                                               {K(1, 0), K(1, 1), K(1, 2)},
+                                               {K(2, 0), K(2, 1), K(2, 2)}};
+    PointUndistorter undistorter(K_rows, model.dist);
+
+    std::vector<cv::Point2d> reference;
+    cv::undistortPoints(points, reference, K, model.dist, cv::noArray(), K,
+                        cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 100, 1e-14));
+
+    std::vector<cv::Point2d> undistorted;
+    std::vector<cv::Point3d> rays;
+    for (const cv::Point2d& point : points) {
+        undistorted.push_back(undistorter.undistort(point));
+        cv::Vec3d ray = K.inv() * cv::Vec3d(undistorted.back().x, undistorted.back().y, 1.0);
+        rays.emplace_back(ray[0], ray[1], 1.0);
+    }
+    std::vector<cv::Point2d> redistorted;
+    cv::projectPoints(rays, cv::Vec3d(0, 0, 0), cv::Vec3d(0, 0, 0), K, model.dist, redistorted);
+
+    UndistortDeviation deviation;
+    for (size_t i = 0; i < points.size(); ++i) {
+        deviation.opencv = std::max(deviation.opencv, cv::norm(undistorted[i] - reference[i]));
+        deviation.round_trip = std::max(deviation.round_trip, cv::norm(redistorted[i] - points[i]));
+    }
+    return deviation;
+}
+
+// Tests of PointUndistorter (undistort.h) against cv::undistortPoints for the 4, 5 and 8 coefficient
+// models, mild and strong, on a 1280x1024 camera with the corners and edges of the image included
+int main() {
+    const int width = 1280;
+    const int height = 1024;
+    const cv::Matx33d K(834.06423862, 0.0, 639.5, 0.0, 834.06423862, 511.5, 0.0, 0.0, 1.0);
+    const std::vector<cv::Point2d> points = makeImagePoints(width, height);
+
+    const LensModel models[] = {
+        {"4 coefficients", {-0.12, 0.05, 1e-3, -5e-4}},
+        {"5 coefficients", {-0.12, 0.05, 1e-3, -5e-4, -0.01}},
+        {"5 coefficients, strong barrel", {-0.25, 0.05, 2e-3, 1e-3, 0.005}},
+        {"8 coefficients", {0.3, -0.05, 1e-3, -5e-4, 0.01, 0.45, -0.02, 0.005}},
+        {"8 coefficients, strong rational", {-0.8, 0.4, 1e-3, 1e-3, -0.05, -0.5, 0.2, -0.02}},
+    };
+
+    // Both converge to well below a thousandth of a pixel. A disabled undistorter leaves points alone.
+    for (const LensModel& model : models) {
+        UndistortDeviation deviation = compareUndistortion(K, model, points);
+        std::string label = model.name;
+        checkNear(deviation.opencv, 0.0, 1e-3, label + ": against cv::undistortPoints");
+        checkNear(deviation.round_trip, 0.0, 1e-3, label + ": round trip through cv::projectPoints");
+    }
+    UndistortDeviation identity = compareUndistortion(K, {"no distortion", {0.0, 0.0, 0.0, 0.0}}, points);
+    checkNear(identity.opencv, 0.0, 1e-9, "no distortion: against cv::undistortPoints");
+
+    return finishTests("undistort_test");
+}
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "multi_camera_setup/world_tracker.h"
+#include "test_utils.h"
+
+// Function to get the projection matrix of a camera at center looking at target, world Y up
+cv::Matx34d lookAt(const cv::Matx33d& K, const cv::Vec3d& center, const cv::Vec3d& target) {
+    cv::Vec3d forward = cv::normalize(target - center);
+    cv::Vec3d right = cv::normalize(forward.cross(cv::Vec3d(0.0, 1.0, 0.0)));
+    cv::Vec3d down = forward.cross(right);
+    cv::Matx33d R(right[0], right[1], right[2], down[0], down[1], down[2], forward[0], forward[1], forward[2]);
+    cv::Vec3d t = -(R * center);
+    cv::Matx34d Rt(R(0, 0), R(0, 1), R(0, 2), t[0],
+                   R(1, 0), R(1, 1), R(1, 2), t[1],
+                   R(2, 0), R(2, 1), R(2, 2), t[2]);
+    return K * Rt;
+}
+
+// Function to project a world point with a projection matrix
+cv::Point2d project(const cv::Matx34d& P, const cv::Vec3d& point) {
+    cv::Vec3d x = P * cv::Vec4d(point[0], point[1], point[2], 1.0);
+    return cv::Point2d(x[0] / x[2], x[1] / x[2]);
+}
+
+// Tests of WorldTracker (world_tracker.h) on a noiseless ballistic throw seen by four cameras at 100 fps:
+// started 5 cm off and at rest, the tracker must lock on to the position and velocity within a third of
+// a second and stay on them, and must gate out an observation that is far off the track
+int main() {
+    const cv::Matx33d K(834.06423862, 0.0, 639.5, 0.0, 834.06423862, 511.5, 0.0, 0.0, 1.0);
+    const cv::Vec3d target(0.0, 1.5, 0.0);
+    std::vector<cv::Matx34d> projections;
+    for (int i = 0; i < 4; ++i) {
+        double angle = CV_PI / 2.0 * i + 0.3;
+        projections.push_back(lookAt(K, cv::Vec3d(7.0 * std::cos(angle), 2.0, 7.0 * std::sin(angle)), target));
+    }
+
+    WorldTrackerConfig config;
+    config.use_gravity = true;
+    WorldTracker tracker(config);
+
+    const cv::Vec3d start(-2.0, 1.0, 0.0);
+    const cv::Vec3d launch(4.0, 5.0, 1.0);
+    const double frame_time = 0.01;
+    const int frames = 120;
+    tracker.initialize(cv::Point3d(start[0] + 0.03, start[1] - 0.03, start[2] + 0.03), 0.0);
+    check(tracker.isInitialized(), "initialized");
+
+    int rejected = 0;
+    double position_error = 0.0;
+    double velocity_error = 0.0;
+    for (int frame = 1; frame < frames; ++frame) {
+        double t = frame * frame_time;
+        cv::Vec3d position = start + launch * t + config.gravity * (0.5 * t * t);
+        cv::Vec3d velocity = launch + config.gravity * t;
+
+        tracker.predict(t);
+        for (const cv::Matx34d& P : projections) {
+            rejected += tracker.update(P, project(P, position)) ? 0 : 1;
+        }
+
+        // Worst error once the tracker has had a third of a second to converge
+        if (t >= 0.33) {
+            cv::Point3d estimate = tracker.position();
+            position_error = std::max(position_error,
+                                      cv::norm(cv::Vec3d(estimate.x, estimate.y, estimate.z) - position));
+            velocity_error = std::max(velocity_error, cv::norm(tracker.velocity() - velocity));
+        }
+    }
+    check(rejected == 0, "no noiseless observation is gated out (" + std::to_string(rejected) + " were)");
+    checkNear(position_error, 0.0, 1e-6, "position error after convergence (m)");
+    checkNear(velocity_error, 0.0, 1e-4, "velocity error after convergence (m/s)");
+    checkNear(tracker.timestamp(), (frames - 1) * frame_time, 1e-12, "timestamp of the last predict");
+
+    // A stale timestamp leaves the state alone, an observation 100 pixels off the track is gated out
+    cv::Point3d before = tracker.position();
+    tracker.predict(0.5);
+    check(tracker.position() == before, "predict to a past timestamp is a no-op");
+    double t = tracker.timestamp();
+    cv::Vec3d last = start + launch * t + config.gravity * (0.5 * t * t);
+    cv::Point2d outlier = project(projections[0], last) + cv::Point2d(100.0, 0.0);
+    check(!tracker.update(projections[0], outlier), "an observation far off the track is gated out");
+    check(tracker.position() == before, "a gated observation leaves the state alone");
+
+    return finishTests("world_tracker_test");
+}